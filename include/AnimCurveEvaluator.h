@@ -0,0 +1,102 @@
+//
+//  AnimCurveEvaluator.h
+//  MotionPath
+//
+//
+
+#ifndef ANIMCURVEEVALUATOR_H
+#define ANIMCURVEEVALUATOR_H
+
+#include <vector>
+
+class MFnAnimCurve;
+class MPlug;
+class MTime;
+
+// Flat snapshot of a time based animation curve which can be evaluated without going through the DG.
+// Times are in seconds, values in the curve internal units, the same as MFnAnimCurve::evaluate.
+// The evaluation itself only deals with plain doubles, the Maya specific bits (snapshot/validate) live in AnimCurveSnapshot.cpp.
+class AnimCurveEvaluator
+{
+    public:
+        enum Infinity{
+            kConstant = 0,
+            kLinear,
+            kCycle,
+            kCycleRelative,
+            kOscillate};
+
+        struct Key
+        {
+            double time, value;
+            // tangent vectors as returned by MFnAnimCurve::getTangent
+            double inX, inY, outX, outY;
+            bool stepOut, stepNextOut;
+            // neither tangent follows the key values (fixed, flat, step), Maya recomputes the others when a key moves
+            bool fixedTangents;
+        };
+
+        AnimCurveEvaluator();
+
+        void clear();
+        void setConstant(const double value);
+        bool setKeys(const std::vector<Key> &keys, const bool weighted, const Infinity preInfinity, const Infinity postInfinity);
+
+        bool isValid() const {return valid;}
+
+        // adds or replaces a key on the snapshot only, used to preview values that were not keyed yet
+        bool overlayKey(const double time, const double value);
+        // moves the value of the key at time on the snapshot only, the curve is left as it is.
+        // Only possible when the key and its neighbours have fixed tangents, otherwise Maya would recompute them
+        bool canOffsetKey(const double time) const;
+        bool offsetKey(const double time, const double offset);
+
+        double evaluate(const double time) const;
+        // evaluates count samples starting at startTime, walking the segments once rather than searching for each sample.
+        // The samples of a hermite segment are evaluated as a batch, giving the same bits as evaluate
+        void evaluateRange(const double startTime, const double step, const int count, double *values) const;
+
+        // fills the snapshot from the curve driving the plug, fails if the plug is driven by anything else than a plain time curve
+        bool snapshot(const MPlug &plug);
+        bool snapshot(const MFnAnimCurve &curve);
+        // compares a few samples around each key against MFnAnimCurve::evaluate
+        bool validate(const MFnAnimCurve &curve, const double tolerance = 1.0e-6) const;
+        // compares a constant snapshot against the plug at the ends of the playback range
+        bool validateConstant(const MPlug &plug, const double tolerance = 1.0e-6) const;
+        // overlays the current value of the plug when it is not what its curve gives at time (moved but not keyed yet)
+        bool overlayLiveValue(const MPlug &plug, const MTime &time);
+
+    private:
+        struct Segment
+        {
+            double startTime, endTime;
+            double startValue, endValue;
+            // power basis coefficients for the value, and for the time if the segment is weighted
+            double y[4];
+            double x[4];
+            bool weighted;
+            bool step, stepNext;
+        };
+
+        bool valid;
+        bool constant;
+        double constantValue;
+        bool weighted;
+        std::vector<Key> keys;
+        std::vector<Segment> segments;
+        Key firstKey, lastKey;
+        Infinity preInfinity, postInfinity;
+
+        bool buildSegment(const std::size_t index);
+        double evaluateSegment(const Segment &segment, const double time) const;
+        // samples [first, end) of a range, all inside the same hermite segment, two at a time where SSE2 is around
+        static void evaluateHermite(const Segment &segment, const double startTime, const double step, const int first, const int end, double *values);
+        double evaluateInfinity(const double time) const;
+        double evaluateInRange(const double time) const;
+        int findSegment(const double time) const;
+        int findKey(const double time) const;
+
+        static double solveBezierTime(const double *x, const double time);
+};
+
+#endif
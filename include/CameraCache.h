@@ -17,6 +17,8 @@
 
 #include <map>
 
+#include "TransformChainEvaluator.h"
+
 class CameraCache
 {
     public:
@@ -40,8 +42,12 @@ class CameraCache
     private:
         bool caching, initialized;
         MPlug worldMatrixPlug;
-        MPlug txPlug, tyPlug, tzPlug;
-        MPlug rxPlug, ryPlug, rzPlug;
+        MDagPath cameraPath;
+        MObject transformObject;
+        TransformChainEvaluator chainEvaluator;
+        bool nativeCamera;
+    
+        MMatrix getInverseMatrixAtTime(const double time);
 };
 
 typedef std::map<std::string, CameraCache> CameraCacheMap;
@@ -0,0 +1,48 @@
+//
+//  DrawGovernor.h
+//  MotionPath
+//
+//
+
+#ifndef DRAWGOVERNOR_H
+#define DRAWGOVERNOR_H
+
+#include <map>
+
+// Keeps the time spent drawing each panel under GlobalSettings::drawTimeBudget.
+// A panel whose average draw time goes over budget drops one quality level, the levels are cumulative.
+// Once it has been well under budget for a while it gets one level back
+class DrawGovernor
+{
+    public:
+        enum Level{
+            kFull = 0,
+            kNoLabels,
+            kNoTangents,
+            kSparseFrames,
+            kSimplifiedPath,
+            kNumLevels};
+
+        Level getPanelLevel(const void *panel) const;
+        void reportPanelTime(const void *panel, const double milliseconds);
+        // lowest quality any panel is drawn at
+        Level getLevel() const;
+
+        void removePanel(const void *panel) {panels.erase(panel);}
+        void clear() {panels.clear();}
+
+    private:
+        struct PanelState
+        {
+            PanelState(): level(kFull), averageTime(0), samples(0), calmDraws(0) {}
+
+            Level level;
+            double averageTime;
+            int samples;
+            int calmDraws;
+        };
+
+        std::map<const void*, PanelState> panels;
+};
+
+#endif
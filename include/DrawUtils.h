@@ -21,6 +21,7 @@
 
 #include <Keyframe.h>
 #include <CameraCache.h>
+#include "PathGeometry.h"
 
 namespace drawUtils
 {
@@ -36,11 +37,14 @@ namespace drawUtils
     
     void drawKeyFramePoints(KeyframeMap &keyframesCache, const float size, const double colorMultiplier, const int portWidth, const int portHeight, const bool showRotationKeyframes);
     
-    void drawKeyFrames(std::vector<Keyframe *> keys, const float size, const double colorMultiplier,const int portWidth, const int portHeight, const bool showRotationKeyframes);
+    void drawKeyFrames(const std::vector<Keyframe *> &keys, const float size, const double colorMultiplier,const int portWidth, const int portHeight, const bool showRotationKeyframes);
     
     void convertWorldSpaceToCameraSpace(CameraCache* cachePtr, std::map<double, MPoint> &positions, std::map<double, MPoint> &screenSpacePositions);
     
     void drawFrameLabel(double frame, const MVector &framePos, M3dView &view, const double sizeOffset, const MColor &color, const MMatrix &refMatrix);
+    
+    // one glDrawArrays from client arrays for all the vertices of an item, mode is GL_LINES or GL_POINTS
+    void drawPathGeometry(const PathGeometry &geometry, const PathGeometry::Item item, const GLenum mode, float size);
     /*
     void drawCameraSpaceFrames(CameraCache* cachePtr, const MColor &color, std::map<double, MPoint> &positions, const double startFrame, const double endFrame);
 
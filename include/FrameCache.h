@@ -0,0 +1,211 @@
+//
+//  FrameCache.h
+//  MotionPath
+//
+//
+
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include <vector>
+#include <map>
+#include <cmath>
+
+// Sliding window of per-frame values indexed by integer frame.
+// Whole frames live in a contiguous array so that walking a range of frames is a linear scan,
+// sub-frame samples (i.e. the tangent evaluations) go in a small side table.
+// References returned by find/set stay valid until the next call that grows, re-bases or evicts the window.
+template <typename T>
+class FrameCache
+{
+    public:
+        FrameCache(): firstFrame(0), numValid(0) {}
+
+        bool contains(const double time) const {return find(time) != NULL;}
+
+        const T* find(const double time) const
+        {
+            int frame;
+            if (!wholeFrame(time, frame))
+            {
+                typename std::map<double, T>::const_iterator it = subFrames.find(time);
+                return it == subFrames.end() ? NULL : &it->second;
+            }
+
+            int index = frame - firstFrame;
+            if (index < 0 || index >= static_cast<int>(values.size()) || !valid[index])
+                return NULL;
+            return &values[index];
+        }
+
+        T* find(const double time)
+        {
+            return const_cast<T*>(static_cast<const FrameCache<T>*>(this)->find(time));
+        }
+
+        T& set(const double time, const T &value)
+        {
+            int frame;
+            if (!wholeFrame(time, frame))
+                return subFrames[time] = value;
+
+            reserve(frame, frame);
+            int index = frame - firstFrame;
+            if (!valid[index])
+            {
+                valid[index] = 1;
+                ++numValid;
+            }
+            values[index] = value;
+            return values[index];
+        }
+
+        // makes sure the window covers [first, last] so that filling the range never reallocates.
+        // A range far away from what we hold (i.e. jumping from frame 0 to 50000) re-bases the window
+        // instead of allocating the gap, the old frames are dropped
+        void reserve(const int first, const int last)
+        {
+            int currentLast = firstFrame + static_cast<int>(values.size()) - 1;
+            if (!values.empty() && first >= firstFrame && last <= currentLast)
+                return;
+
+            int gap = 0;
+            if (first > currentLast) gap = first - currentLast;
+            else if (last < firstFrame) gap = firstFrame - last;
+
+            int maxGap = static_cast<int>(values.size());
+            if (maxGap < kMinRebaseGap) maxGap = kMinRebaseGap;
+
+            if (values.empty() || numValid == 0 || gap > maxGap)
+            {
+                std::vector<T>(last - first + 1).swap(values);
+                std::vector<unsigned char>(last - first + 1, 0).swap(valid);
+                firstFrame = first;
+                numValid = 0;
+                return;
+            }
+
+            // grow with some slack in the direction we are moving so that frame by frame expansion stays amortised
+            int slack = static_cast<int>(values.size()) / 2;
+            if (slack < 16) slack = 16;
+
+            int newFirst = firstFrame;
+            int newLast = currentLast;
+            if (first < firstFrame) newFirst = first - slack;
+            if (last > currentLast) newLast = last + slack;
+
+            std::vector<T> newValues(newLast - newFirst + 1);
+            std::vector<unsigned char> newValid(newLast - newFirst + 1, 0);
+            int offset = firstFrame - newFirst;
+            for (size_t i = 0; i < values.size(); ++i)
+            {
+                if (!valid[i]) continue;
+                newValues[i + offset] = values[i];
+                newValid[i + offset] = 1;
+            }
+
+            values.swap(newValues);
+            valid.swap(newValid);
+            firstFrame = newFirst;
+        }
+
+        // evaluates every missing whole frame in [first, last] with the given functor
+        template <typename Evaluator>
+        void fillRange(const int first, const int last, Evaluator &evaluator)
+        {
+            if (last < first) return;
+
+            reserve(first, last);
+            for (int frame = first; frame <= last; ++frame)
+            {
+                int index = frame - firstFrame;
+                if (valid[index]) continue;
+
+                values[index] = evaluator(static_cast<double>(frame));
+                valid[index] = 1;
+                ++numValid;
+            }
+        }
+
+        // drops every sample outside [first, last], sub-frame ones included
+        void evictOutside(const double first, const double last)
+        {
+            for (size_t i = 0; i < valid.size(); ++i)
+            {
+                double frame = firstFrame + static_cast<double>(i);
+                if (valid[i] && (frame < first || frame > last))
+                {
+                    valid[i] = 0;
+                    --numValid;
+                }
+            }
+
+            typename std::map<double, T>::iterator it = subFrames.begin();
+            while (it != subFrames.end())
+            {
+                if (it->first < first || it->first > last)
+                    subFrames.erase(it++);
+                else
+                    ++it;
+            }
+
+            shrink();
+        }
+
+        void clear()
+        {
+            values.clear();
+            valid.clear();
+            subFrames.clear();
+            firstFrame = 0;
+            numValid = 0;
+        }
+
+        size_t size() const {return numValid + subFrames.size();}
+
+    private:
+        enum {kMinRebaseGap = 1024};
+
+        // gives back the storage once the valid frames only use a small part of it,
+        // half is the threshold so that a window sliding back and forth doesn't reallocate all the time
+        void shrink()
+        {
+            if (numValid == 0)
+            {
+                std::vector<T>().swap(values);
+                std::vector<unsigned char>().swap(valid);
+                firstFrame = 0;
+                return;
+            }
+
+            size_t lo = 0, hi = valid.size() - 1;
+            while (!valid[lo]) ++lo;
+            while (!valid[hi]) --hi;
+            if ((hi - lo + 1) * 2 > values.size())
+                return;
+
+            std::vector<T> newValues(values.begin() + lo, values.begin() + hi + 1);
+            std::vector<unsigned char> newValid(valid.begin() + lo, valid.begin() + hi + 1);
+            values.swap(newValues);
+            valid.swap(newValid);
+            firstFrame += static_cast<int>(lo);
+        }
+
+        static bool wholeFrame(const double time, int &frame)
+        {
+            double rounded = std::floor(time + 0.5);
+            if (std::fabs(time - rounded) > 1e-6)
+                return false;
+
+            frame = static_cast<int>(rounded);
+            return true;
+        }
+
+        std::vector<T> values;
+        std::vector<unsigned char> valid;
+        int firstFrame;
+        size_t numValid;
+        std::map<double, T> subFrames;
+};
+
+#endif
@@ -5,6 +5,8 @@
 #include <maya/MColor.h>
 #include <maya/MMatrix.h>
 
+#include "ScreenProjector.h"
+
 #include <map>
 
 class GlobalSettings
@@ -36,7 +38,21 @@ class GlobalSettings
         static bool showPath;
         static double drawTimeInterval;
         static int drawFrameInterval;
+        static int cacheFillBudget;
+        static int prefetchFrames;
+        static int samplingThreads;
+        // world space paths kept in viewport 2.0 buffers, off by default: they hang on a hidden locator so
+        // isolate select and the Locators show filter hide them, the per refresh draw has no such problem
+        static bool persistentGeometry;
+        // pixels the simplified frames line may drift from the full one, 0 draws every frame
+        static double simplifyTolerance;
+        // most frame labels drawn in a panel
+        static int labelBudget;
+        // milliseconds a panel may spend drawing the paths before the governor lowers the detail, 0 turns it off
+        static double drawTimeBudget;
 		static MMatrix cameraMatrix;
+        // projection of the panel being drawn, set next to cameraMatrix
+        static ScreenProjector screenProjector;
         static int portWidth;
         static int portHeight;
         static bool lockedMode;
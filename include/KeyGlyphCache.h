@@ -0,0 +1,55 @@
+//
+//  KeyGlyphCache.h
+//  MotionPath
+//
+//
+
+#ifndef KEYGLYPHCACHE_H
+#define KEYGLYPHCACHE_H
+
+#include <maya/MPoint.h>
+#include <maya/MPointArray.h>
+#include <maya/MColorArray.h>
+#include <maya/MViewport2Renderer.h>
+
+#include <vector>
+
+#include "Keyframe.h"
+
+// Viewport 2.0 keyframe glyphs of a path: the black background, the translate axis disks or the selection disk
+// and the rotation axis strokes. The glyphs are built around the origin and only rebuilt when the axes keyed,
+// the selection or the style change; drawing moves them to the projected keys and sends all of them
+// as one triangle mesh and one line mesh
+class KeyGlyphCache
+{
+    public:
+        KeyGlyphCache(): size(0), colorMultiplier(0), showRotation(false) {}
+
+        void update(const std::vector<Keyframe*> &keys, const float size, const double colorMultiplier, const bool showRotation);
+        // centers are the viewport positions of the keys given to update, keys not visible are skipped
+        void draw(const std::vector<MPoint> &centers, const std::vector<unsigned char> &visible, MHWRender::MUIDrawManager* drawManager) const;
+
+    private:
+        struct Glyph
+        {
+            // axis bits, 1 << Keyframe::Axis, for translation and rotation
+            unsigned char translateMask, rotateMask;
+            bool selected;
+            unsigned int firstTriangleVertex, triangleVertexCount;
+            unsigned int firstLineVertex, lineVertexCount;
+        };
+
+        float size;
+        double colorMultiplier;
+        bool showRotation;
+        std::vector<Glyph> glyphs;
+
+        MPointArray triangleVertices, lineVertices;
+        MColorArray triangleColors, lineColors;
+
+        bool isCurrent(const std::vector<Keyframe*> &keys, const float size, const double colorMultiplier, const bool showRotation) const;
+        void addDisk(const double radius, const MColor &color);
+        void buildGlyph(Glyph &glyph);
+};
+
+#endif
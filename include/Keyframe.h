@@ -67,6 +67,11 @@ class Keyframe
         MVector inTangentWorldFromCurve;
         MVector outTangentWorldFromCurve;
     
+        //world positions sampled when the keys were cached, projected into worldPosition and the tangents on every draw
+        MVector pathWorldPosition;
+        MVector inCurveWorldPosition;
+        MVector outCurveWorldPosition;
+    
         bool selectedFromTool;
 };
 
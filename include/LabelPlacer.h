@@ -0,0 +1,57 @@
+//
+//  LabelPlacer.h
+//  MotionPath
+//
+//
+
+#ifndef LABELPLACER_H
+#define LABELPLACER_H
+
+#include <maya/MVector.h>
+#include <maya/MColor.h>
+#include <maya/MMatrix.h>
+#include <maya/M3dView.h>
+#include <maya/MViewport2Renderer.h>
+
+#include <vector>
+
+#include "ScreenProjector.h"
+
+// Collects the frame number labels of every path drawn in a panel and keeps only the ones that can be read:
+// labels off screen or over a label already placed are dropped using a uniform grid of occupied cells,
+// keyframe labels are placed first and no more than the panel budget are drawn
+class LabelPlacer
+{
+    public:
+        enum Priority{
+            kKeyFrame = 0,
+            kTenthFrame,
+            kFifthFrame,
+            kFrame,
+            kNumPriorities};
+
+        void begin(const int portWidth, const int portHeight);
+        void addLabel(const double frame, const MVector &worldPosition, const double sizeOffset, const MColor &color, const Priority priority);
+        // projects, places and draws what was added since begin
+        void draw(const ScreenProjector &projector, M3dView &view, const MMatrix &refMatrix, MHWRender::MUIDrawManager* drawManager);
+
+        static Priority priorityForFrame(const double frame, const bool hasKey);
+
+    private:
+        struct Label
+        {
+            double frame;
+            MVector worldPosition;
+            double sizeOffset;
+            MColor color;
+        };
+
+        int width, height;
+        int columns, rows;
+        std::vector<Label> labels[kNumPriorities];
+        std::vector<unsigned char> occupied;
+
+        bool place(const double x, const double y, const double frame);
+};
+
+#endif
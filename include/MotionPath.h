@@ -18,6 +18,7 @@
 #include <maya/MFnDependencyNode.h>
 #include <maya/MFnDagNode.h>
 #include <maya/MFnMatrixData.h>
+#include <maya/MDGContext.h>
 #include <maya/MStringArray.h>
 #include <maya/M3dView.h>
 #include <maya/MQuaternion.h>
@@ -30,9 +31,40 @@
 #include <BufferPath.h>
 #include "KeyClipboard.h"
 #include "CameraCache.h"
+#include "FrameCache.h"
+#include "AnimCurveEvaluator.h"
+#include "TransformChainEvaluator.h"
+#include "PathGeometry.h"
+#include "SegmentBounds.h"
+#include "PathSimplifier.h"
+#include "KeyGlyphCache.h"
+#include "PickIndex.h"
 
 #include <map>
 
+//everything we need from the transform at a given time, read under a single context
+struct PathSample
+{
+    MVector position;
+    MMatrix pMatrix;
+    MVector worldPosition;
+};
+
+//one key of a batch edit, the position is in world space for kSet and a raw curve offset for kOffset as offsetWorldPosition
+struct KeyEdit
+{
+    enum Operation{
+        kSet = 0,
+        kOffset,
+        kDelete};
+    
+    KeyEdit(const Operation operation, const double time, const MVector &position = MVector::zero): operation(operation), time(time), position(position) {}
+    
+    Operation operation;
+    double time;
+    MVector position;
+};
+
 class MotionPath
 {
     public:
@@ -45,7 +77,26 @@ class MotionPath
         void setTimeRange(double startTime, double endTime);
         void setDisplayTimeRange(double start, double end);
         void growParentAndPivotMatrixCache(double time, double expansion);
+        void beginDraw();
+        //true when the object moved since the last beginDraw without anything else telling us
+        bool liveValuesChanged();
+        void prepareKeyFrames(CameraCache* cachePtr);
+        //world space unless a camera cache is given, simplified for the view when a projector is given
+        void fillGeometry(PathGeometry &geometry, CameraCache* cachePtr = NULL, const ScreenProjector* projector = NULL);
+        //what fillGeometry would draw in world space, the shared settings come in with sceneStamp
+        unsigned int getGeometryStamp(const unsigned int sceneStamp);
+        //screen positions of the keys, shown tangent handles and frames as just drawn in the panel
+        void addPickItems(PickIndex &pickIndex, const int pathIndex, CameraCache* cachePtr, const ScreenProjector &projector);
         void draw(M3dView &view, CameraCache* cachePtr, MHWRender::MUIDrawManager* drawManager = NULL, const MHWRender::MFrameContext* frameContext = NULL);
+        void cacheSampleAtTime(const double time, MDGContext &context);
+        
+        //samples of paths whose curves and hierarchy were snapshotted, computeNativeSamples is safe to call from worker threads
+        bool hasNativeSamples();
+        int getNativeSampleCount() const {return static_cast<int>(nativePositions.size());}
+        void computeNativeSamples(const int first, const int count, PathSample *samples, unsigned char *newMatrix) const;
+        void publishNativeSamples(const std::vector<PathSample> &samples, const std::vector<unsigned char> &newMatrix);
+        double getDisplayStartTime(){return displayStartTime;};
+        double getDisplayEndTime(){return displayEndTime;};
     
         bool isConstrained(){return constrained;};
     
@@ -63,12 +114,8 @@ class MotionPath
     
         //void drawWorldSpace(M3dView &view, CameraCache* cachePtr, const bool selecting);
         //void drawCameraSpace(M3dView &view, CameraCache* cachePtr, const bool selecting);
-        void drawPath(M3dView &view, CameraCache* cachePtr, const MMatrix &currentCameraMatrix, const bool selecting, MHWRender::MUIDrawManager* drawManager = NULL, const MHWRender::MFrameContext* frameContext = NULL);
+        void drawPath(M3dView &view, CameraCache* cachePtr, const MMatrix &currentCameraMatrix, MHWRender::MUIDrawManager* drawManager = NULL, const MHWRender::MFrameContext* frameContext = NULL);
     
-        void drawCurvesForSelection(M3dView &view, CameraCache* cachePtr);
-        void drawTangentsForSelection(M3dView &view, CameraCache *cachePtr);
-        void drawKeysForSelection(M3dView &view, CameraCache* cachePtr);
-        void drawFramesForSelection(M3dView &view, CameraCache* cachePtr);
     
         void getTangentHandleWorldPosition(const double keyTime, const Keyframe::Tangent &tangentName, MVector &tangentWorldPosition);
         void getKeyWorldPosition(const double keyTime, MVector &keyWorldPosition);
@@ -78,6 +125,14 @@ class MotionPath
         void deleteKeyFrameAtTime(const double time, MAnimCurveChange *change, const bool useCache=true);
     
         void offsetWorldPosition(const MVector &offset, const double time, MAnimCurveChange *change);
+        //deletes first, then sets and offsets; kSet adds the key where it is missing. Writes are grouped per curve
+        void applyKeyEdits(const std::vector<KeyEdit> &edits, MAnimCurveChange *change);
+        //drag preview, the key only moves on our curve snapshot until the offsets are committed
+        //keys whose tangents Maya would recompute can't be previewed, false means the offset has to be written instead.
+        //The samples only follow in refreshPreviewSamples, called once all the selected keys were moved
+        bool previewOffsetWorldPosition(const MVector &offset, const double time);
+        void refreshPreviewSamples();
+        void commitPreviewOffsets(MAnimCurveChange *change);
         void setFrameWorldPosition(const MVector &position, const double time, MAnimCurveChange *change);
         void setTangentWorldPosition(const MVector &position, const double time, Keyframe::Tangent tangentId, const MMatrix &toWorldMatrix, MAnimCurveChange *change);
         void rotateTangentWorldPositionAroundAxis(const double angle, const MVector &axis, const double stretch, const double time, Keyframe::Tangent tangentId, MAnimCurveChange *change);
@@ -91,12 +146,17 @@ class MotionPath
         void getBoundariesForTime(const double time, double *minBoundary, double *maxBoundary);
         int getNumKeyFrames();
         MVector getPos(double time);
+        MVector getPos(MDGContext &context);
         MVector getWorldPositionAtTime(const double time);
     
         void clearParentMatrixCache();
+        void prefetchParentMatrixAtTime(const double time);
+        //returns true when frames were dropped from the cached range, the cache has to be filled again
+        bool evictParentMatrixCache(const double keepStart, const double keepEnd);
         void cacheParentMatrixRange();
     
         void setIsDrawing(const bool value){isDrawing = value;};
+        void setKeyframesDirty(){keyframesDirty = true;};
         void setEndrawingTime(const double value){endDrawingTime = value;};
     
         BufferPath createBufferPath();
@@ -109,6 +169,7 @@ class MotionPath
         static MVector multPosByParentMatrix(const MVector &vec, const MMatrix &mat);
     
         static MMatrix getMatrixFromPlug(const MPlug &matrixPlug, const MTime &t);
+        static MMatrix getMatrixFromPlug(const MPlug &matrixPlug, MDGContext &context);
     
         void addWorldMatrixCallback();
         void removeWorldMartrixCallback();
@@ -117,7 +178,6 @@ class MotionPath
         void setWorldSpaceCallbackCalled(const bool value, const MObject &tempAncestorNode);
 
 		KeyframeMap *keyFramesCachePtr() { return &keyframesCache; }
-		void getFramePositions(std::vector<std::pair<int, MVector>> &vec);
 
     private:
     
@@ -130,7 +190,36 @@ class MotionPath
         bool constrained;
         bool selectedFromTool;
         MPlug pMatrixPlug;
-        std::map<double, MMatrix> pMatrixCache;
+        FrameCache<MMatrix> pMatrixCache;
+        FrameCache<PathSample> sampleCache;
+        AnimCurveEvaluator translateEvaluators[3];
+        bool nativeTranslate;
+        //validated snapshots of the translate curves, translateEvaluators start from a copy of them every draw
+        AnimCurveEvaluator translateSnapshots[3];
+        bool translateSnapshotsNative;
+        bool translateSnapshotsValid;
+        unsigned int translateSnapshotsVersion;
+        std::vector<MVector> nativePositions;
+        double nativePositionsStart;
+        //the time of each native sample in seconds, converted on the main thread since MTime reads the scene settings
+        std::vector<double> nativeSeconds;
+        //offsets of the keys being dragged, applied again whenever the snapshot is taken
+        std::map<double, MVector> previewOffsets;
+        bool previewSamplesDirty;
+        TransformChainEvaluator chainEvaluator;
+        bool chainSnapshotDirty;
+        bool keyframesDirty;
+        //bumped whenever the keys are rebuilt or the samples refreshed outside of beginDraw
+        unsigned int geometryVersion;
+        double keyframesStartTime, keyframesEndTime;
+        bool keyframesShowRotation, keyframesDrawing;
+        MMatrix drawWorldMatrix;
+        //kept around so the chunk boxes are not reallocated every draw
+        SegmentBounds segmentBounds;
+        PathSimplifier simplifier;
+        //what the legacy viewport draws, filled once per draw and kept to reuse the allocations
+        PathGeometry legacyGeometry;
+        KeyGlyphCache keyGlyphs;
         bool cacheDone;
         bool worldSpaceCallbackCalled;
         KeyframeMap keyframesCache;
@@ -142,7 +231,7 @@ class MotionPath
         std::map<double, MPoint> frameScreenSpacePositions;
     
         //Pivot stuff
-        MPlug rpxPlug, rpyPlug, rpzPlug, rptxPlug, rptyPlug, rptzPlug;
+        MPlug translatePlug, rotatePivotPlug, rotatePivotTranslatePlug;
         //
     
         bool isWeighted;
@@ -152,17 +241,34 @@ class MotionPath
         bool isDrawing;
         double endDrawingTime;
     
-        void ensureParentAndPivotMatrixAtTime(const double time);
+        const MMatrix &ensureParentAndPivotMatrixAtTime(const double time);
+        PathSample getSample(const double time, MDGContext &context, const bool allowNative);
+        void cacheNativePositions();
+        bool translateSnapshotsStale();
+        MVector getNativePos(const double time);
+        void offsetNativeKey(const double time, const MVector &offset);
+        static void applyKeyEditsOnCurve(MFnAnimCurve &curve, const unsigned int axis, const std::vector<KeyEdit> &edits, const std::vector<MVector> &values, MAnimCurveChange *change);
+        void refreshNativeSamples();
+        void refreshNativeSample(const double time);
+        bool useNativeChain();
+        MMatrix getNativePMatrixAtTime(const double time) const;
+        MMatrix getNativePMatrixAtSeconds(const double seconds) const;
+        static MMatrix applyPivots(const MMatrix &matrix, const MVector &rotatePivot, const MVector &rotatePivotTranslate);
+        PathSample getSampleAtTime(const double time);
+        const PathSample &ensureSampleAtTime(const double time);
         MMatrix getPMatrixAtTime(const MTime &evalTime);
+        MMatrix getPMatrixAtTime(MDGContext &context);
         MMatrix getPivotMatrix(const MTime &evalTime);
-        MVector getVectorFromPlugs(const MTime &evalTime, const MPlug &x, const MPlug &y, const MPlug &z);
+        MVector getVectorFromPlug(MDGContext &context, const MPlug &plug);
     
         bool isCurveTypeAnimatable(MFnAnimCurve::AnimCurveType type);
         bool isConstrained(const MFnDagNode &dagNodeFn);
         void findParentMatrixPlug(const MObject &transform, const bool isConstrained, MPlug &matrixPlug);
         void findPivotPlugs(MFnDependencyNode &depNodFn);
         void expandKeyFramesCache(const MFnAnimCurve &curve, const Keyframe::Axis &axisName, bool isTranslate);
-        void cacheKeyFrames(const MFnAnimCurve &curveTX, const MFnAnimCurve &curveTY, const MFnAnimCurve &curveTZ, const MFnAnimCurve &curveRX, const MFnAnimCurve &curveRY, const MFnAnimCurve &curveRZ, CameraCache* cachePtr, const MMatrix &currentCameraMatrix);
+        void cacheKeyFrames(const MFnAnimCurve &curveTX, const MFnAnimCurve &curveTY, const MFnAnimCurve &curveTZ, const MFnAnimCurve &curveRX, const MFnAnimCurve &curveRY, const MFnAnimCurve &curveRZ);
+        bool keyFramesNeedRebuild();
+        void projectKeyFrames(CameraCache* cachePtr, const MMatrix &currentCameraMatrix);
         void setShowInOutTangents(const MFnAnimCurve &curveTX, const MFnAnimCurve &curveTY, const MFnAnimCurve &curveTZ);
         bool showTangent(const double time, const int firstId, const double firstTime, const int secondId, const double secondTime);
     
@@ -170,7 +276,17 @@ class MotionPath
     
         void deleteKeyFramesAfterTime(const double time, MFnAnimCurve &curve, MAnimCurveChange *change);
     
+        MMatrix getCurrentCameraMatrix(CameraCache* cachePtr);
+        MColor getPathColor();
+        MColor getTangentColor(const Keyframe *key);
         void drawFrames(CameraCache* cachePtr, const MMatrix &currentCameraMatrix, M3dView &view, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext);
+    
+        void drawFramesMesh(CameraCache* cachePtr, const MMatrix &currentCameraMatrix, const MColor &curveColor, MHWRender::MUIDrawManager* drawManager);
+        void collectFramePoints(CameraCache* cachePtr, const MMatrix &currentCameraMatrix, MPointArray &points);
+        void simplifyFrames(const MPointArray &points, const ScreenProjector &projector, std::vector<unsigned char> &keepLine, std::vector<unsigned char> &keepDots);
+        void thinFrames(std::vector<unsigned char> &keepLine, std::vector<unsigned char> &keepDots);
+        void collectForcedFrames(std::vector<unsigned int> &forced);
+        void keepEveryFifthFrame(const std::vector<unsigned int> &forced, std::vector<unsigned char> &keep);
         void drawFrame(const double time, const MVector &pos, const MColor &color, double alpha, M3dView &view, MMatrix &currentCameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext);
         void drawCurrentFrame(CameraCache* cachePtr, const MMatrix &currentCameraMatrix, M3dView &view, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext);
         void drawKeyFrames(CameraCache *cachePtr, MMatrix &currentCameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext);
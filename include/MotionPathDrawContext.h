@@ -73,7 +73,9 @@ private:
     
     MGlobal::ListAdjustment listAdjustment;
     
+    //screen points of the stroke, in draw mode also the preview of the buffered keys
     MVectorArray strokePoints;
+    std::vector<KeyEdit> drawnKeys;
     
     M3dView activeView;
     bool fsDrawn;
@@ -0,0 +1,33 @@
+//
+//  MotionPathGeometryNode.h
+//  MotionPath
+//
+//
+
+#ifndef MOTIONPATHGEOMETRYNODE_H
+#define MOTIONPATHGEOMETRYNODE_H
+
+#include <maya/MPxLocatorNode.h>
+#include <maya/MTypeId.h>
+#include <maya/MString.h>
+
+// Hidden, non saved locator the manager creates while the tool is enabled.
+// It has no data of its own, it only gives viewport 2.0 a node to hang the path render items on
+class MotionPathGeometryNode : public MPxLocatorNode
+{
+    public:
+        MotionPathGeometryNode();
+        virtual ~MotionPathGeometryNode();
+
+        virtual bool isBounded() const;
+
+        static void* creator();
+        static MStatus initialize();
+
+        static MTypeId id;
+        static MString typeName;
+        static MString drawDbClassification;
+        static MString drawRegistrantId;
+};
+
+#endif
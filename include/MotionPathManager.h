@@ -11,8 +11,12 @@
 
 #include "MotionPathEditContext.h"
 #include "MotionPath.h"
+#include "WorkerPool.h"
+#include "LabelPlacer.h"
+#include "DrawGovernor.h"
+#include "PickIndex.h"
 
-#include <time.h>
+#include <chrono>
 
 #include <maya/MGlobal.h>
 #include <maya/MUiMessage.h>
@@ -22,6 +26,7 @@
 #include <maya/MAnimMessage.h>
 #include <maya/MDGMessage.h>
 #include <maya/MDGModifier.h>
+#include <maya/MObjectHandle.h>
 #include <maya/M3dView.h>
 #include <maya/MIntArray.h>
 #include <maya/MStringArray.h>
@@ -46,6 +51,8 @@
 struct RegisteredPanel
 {
 	MString name;
+    //what the governor and the pick indices know the panel by
+    const void *widget;
 	MCallbackId destroyPanelCallbackId;
 	MCallbackId postRenderCallbackId;
     MCallbackId cameraWorldMatrixCallbackId;
@@ -69,10 +76,11 @@ public:
     MStringArray getSelectionList();
     void refreshDisplayTimeRange();
     void setTimeRange(const double start, const double end);
-    bool expandParentMatrixAndPivotCache(const double currentTimeValue);
+    void startCacheFill(const double currentTimeValue);
+    void cancelCacheFill();
+    bool fillCacheChunk();
     MotionPath* getMotionPathPtr(const int id);
     int getMotionPathsCount(){return pathArray.size();};
-    void drawCurvesForSelection(M3dView &view, CameraCache *cachePtr);
 
     void addBufferPaths();
     void deleteAllBufferPaths();
@@ -108,16 +116,56 @@ public:
 	void drawBufferPaths(M3dView &view, CameraCache* cachePtr, MHWRender::MUIDrawManager* drawManager = NULL, const MHWRender::MFrameContext* frameContext = NULL);
 	void drawPaths(M3dView view, CameraCache* cachePtr, MHWRender::MUIDrawManager* drawManager = NULL, const MHWRender::MFrameContext* frameContext = NULL);
     
+    //world space paths are kept in the vertex buffers of a hidden node rather than drawn as ui drawables
+    bool persistentGeometryActive();
+    //adds or removes the hidden locator the persistent buffers hang on
+    void setPersistentGeometry(const bool value);
+    LabelPlacer& getLabelPlacer(){return labelPlacer;};
+    //quality of the panel being drawn, full outside of drawPaths
+    DrawGovernor::Level getDrawLevel(){return drawLevel;};
+    DrawGovernor::Level getGovernorLevel(){return drawGovernor.getLevel();};
+    //what was last drawn in the panel, NULL if it was never drawn
+    const PickIndex* getPickIndex(M3dView &view);
+    int getMotionPathIndex(const MotionPath *motionPathPtr);
+    //refills the paths whose stamp differs from the one in stamps, changed tells which ones were filled
+    void getPathGeometry(std::vector<PathGeometry> &geometry, std::vector<unsigned int> &stamps, std::vector<unsigned char> &changed);
+    //true when getPathGeometry would fill anything with these stamps
+    bool pathGeometryChanged(const std::vector<unsigned int> &stamps);
+    //anything that can change the paths without moving the playhead or the objects bumps the scene version,
+    //the evaluated samples are shared by all the panels until either of them changes
+    void invalidateEvaluation(){++sceneVersion;};
+    unsigned int getSceneVersion(){return sceneVersion;};
+    
     //void destroyCameraCachesAndCameraCallbacks();
     //void createCameraCachesAndCameraCallbacks();
     
 private:
     bool cacheDone;
+    MCallbackId cacheFillCallbackId;
+    double cacheFillCenter;
+    double cacheFillExpansion;
+    
+    double lastPlayheadFrame;
+    std::chrono::steady_clock::time_point lastPlayheadClock;
+    double playheadVelocity;
+    int prefetchDirection;
+    double prefetchLookahead;
+    double prefetchOffset;
     MCallbackIdArray cbIDs;
     RegisteredPanelArray registeredPanels;
     MObjectArray selectionObjects;
     std::vector<MotionPath> pathArray;
+    WorkerPool workerPool;
     std::vector<BufferPath> bufferPathArray;
+    MObjectHandle geometryNode;
+    LabelPlacer labelPlacer;
+    DrawGovernor drawGovernor;
+    DrawGovernor::Level drawLevel;
+    std::map<const void*, PickIndex> pickIndices;
+    unsigned int sceneVersion;
+    bool evaluationValid;
+    unsigned int evaluatedSceneVersion;
+    double evaluatedTime;
     MAnimCurveChange* animCurveChangePtr;
     MDGModifier *dgModifierPtr;
     CameraCacheMap cameraCache;
@@ -135,14 +183,25 @@ private:
     bool isContainedInMObjectArray(const MObjectArray &objArray, const MObject &obj);
     void highlightSelection(const MObjectArray &objArray);
     void setupViewport(const MString &panelName);
+    void applyDisplayTimeRange(const double currentFrame);
+    void cachePathSamples();
+    bool pathsNeedSampling();
+    //scene version, time, the settings fillGeometry reads and the governor level
+    unsigned int getGeometryStamp();
+    void preparePaths(CameraCache* cachePtr);
+    void createGeometryNode();
+    void deleteGeometryNode();
+    void updatePlayheadMotion(const double currentFrame);
     
     static void timeChangeEvent(MTime &currentTime,  void* data);
+    static void cacheFillIdleCallback(void *data);
     static void commandEvent(const MString &message, MCommandMessage::MessageType messageType, void *data);
     static void viewPostRenderCallback(const MString& panelName, void* data);
     static void viewDestroyCallback(const MString& panelName, void* data);
     static void autoKeyframeCallback(bool state, void* data);
     static void deleteAllCallback(void *data);
     static void sceneOpenedCallback(void *data);
+    static void animCurveEditedCallback(MObjectArray &editedCurves, void *data);
     static void cameraWorldMatrixChangedCallback(MObject& transformNode, MDagMessage::MatrixModifiedFlags& modified,void* data);
     static void viewCameraChanged(const MString &str, MObject &node, void *data);
     static void viewCameraNameChanged(MObject &node, const MString &str, void *data);
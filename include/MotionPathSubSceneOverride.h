@@ -0,0 +1,69 @@
+//
+//  MotionPathSubSceneOverride.h
+//  MotionPath
+//
+//
+
+#ifndef MOTIONPATHSUBSCENEOVERRIDE_H
+#define MOTIONPATHSUBSCENEOVERRIDE_H
+
+#include <maya/MPxSubSceneOverride.h>
+#include <maya/MViewport2Renderer.h>
+#include <maya/MShaderManager.h>
+#include <maya/MHWGeometry.h>
+#include <maya/MString.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "PathGeometry.h"
+
+// Keeps the path lines, frame dots and tangents of the world space paths in vertex buffers owned by viewport 2.0.
+// The buffers live across refreshes: when the vertex count of an item does not change only the span of vertices
+// that differs from what was uploaded is sent again, and paths whose stamp did not change are not even refilled,
+// so moving the camera around only redraws them
+class MotionPathSubSceneOverride : public MHWRender::MPxSubSceneOverride
+{
+    public:
+        static MHWRender::MPxSubSceneOverride* creator(const MObject &obj);
+
+        virtual ~MotionPathSubSceneOverride();
+
+        virtual MHWRender::DrawAPI supportedDrawAPIs() const;
+        virtual bool requiresUpdate(const MHWRender::MSubSceneContainer &container, const MHWRender::MFrameContext &frameContext) const;
+        virtual void update(MHWRender::MSubSceneContainer &container, const MHWRender::MFrameContext &frameContext);
+
+    private:
+        MotionPathSubSceneOverride(const MObject &obj);
+
+        struct ItemBuffers
+        {
+            ItemBuffers(): positionBuffer(NULL), colorBuffer(NULL), indexBuffer(NULL) {}
+
+            MHWRender::MVertexBuffer *positionBuffer;
+            MHWRender::MVertexBuffer *colorBuffer;
+            MHWRender::MIndexBuffer *indexBuffer;
+            // what was last uploaded, used to find the span that changed
+            std::vector<float> positions;
+            std::vector<float> colors;
+        };
+
+        MHWRender::MShaderInstance *shaders[PathGeometry::kNumItems];
+        std::map<std::string, ItemBuffers> itemBuffers;
+        std::vector<PathGeometry> geometry;
+        // stamp of what each path last filled, see MotionPathManager::getPathGeometry
+        std::vector<unsigned int> stamps;
+        std::vector<unsigned char> changed;
+        int numPaths;
+
+        bool ensureShaders();
+        void releaseShaders();
+        void updateItem(MHWRender::MSubSceneContainer &container, const MString &name, const PathGeometry::Item itemType, const std::vector<float> &positions, const std::vector<float> &colors);
+        void removeItem(MHWRender::MSubSceneContainer &container, const MString &name);
+
+        static MString itemName(const int pathIndex, const int itemType);
+        static void releaseBuffers(ItemBuffers &buffers);
+};
+
+#endif
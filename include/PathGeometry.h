@@ -0,0 +1,60 @@
+//
+//  PathGeometry.h
+//  MotionPath
+//
+//
+
+#ifndef PATHGEOMETRY_H
+#define PATHGEOMETRY_H
+
+#include <maya/MVector.h>
+#include <maya/MColor.h>
+
+#include <vector>
+#include <cstddef>
+
+// World space vertices of what a path draws, laid out as the viewport 2.0 vertex buffers expect them:
+// 3 floats per position and 4 floats per color, one entry per vertex
+struct PathGeometry
+{
+    enum Item{
+        kPath = 0,
+        kFrames,
+        kTangents,
+        kHandles,
+        kNumItems};
+
+    std::vector<float> positions[kNumItems];
+    std::vector<float> colors[kNumItems];
+
+    void clear()
+    {
+        for (int i = 0; i < kNumItems; ++i)
+        {
+            positions[i].clear();
+            colors[i].clear();
+        }
+    }
+
+    // folds the bytes of a value into a stamp (FNV-1a), equal stamps mean nothing fillGeometry reads has changed
+    static void addToStamp(unsigned int &stamp, const void *data, const size_t size)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+            stamp = (stamp ^ bytes[i]) * 16777619u;
+    }
+
+    void addVertex(const Item item, const MVector &position, const MColor &color)
+    {
+        positions[item].push_back(static_cast<float>(position.x));
+        positions[item].push_back(static_cast<float>(position.y));
+        positions[item].push_back(static_cast<float>(position.z));
+
+        colors[item].push_back(color.r);
+        colors[item].push_back(color.g);
+        colors[item].push_back(color.b);
+        colors[item].push_back(color.a);
+    }
+};
+
+#endif
@@ -0,0 +1,38 @@
+//
+//  PathSimplifier.h
+//  MotionPath
+//
+//
+
+#ifndef PATHSIMPLIFIER_H
+#define PATHSIMPLIFIER_H
+
+#include <maya/MPoint.h>
+#include <maya/MPointArray.h>
+
+#include <vector>
+
+#include "ScreenProjector.h"
+
+// Douglas-Peucker error hierarchy over the frames of a path. Every frame stores the world distance at which the
+// simplification would start dropping it, clamped so a frame never outlives the one that split its span.
+// The hierarchy only depends on the points, so moving the camera just compares those errors with the size of a pixel
+class PathSimplifier
+{
+    public:
+        // rebuilds the hierarchy when the points are not the ones it was built for
+        void update(const MPointArray &points);
+
+        // keepLine marks the frames the line has to go through to stay within tolerance pixels of the full one,
+        // keepDots the frames whose dot is not within tolerance pixels of the previous dot drawn.
+        // Forced frames are always kept in both
+        void select(const ScreenProjector &projector, const double tolerance, const std::vector<unsigned int> &forced, std::vector<unsigned char> &keepLine, std::vector<unsigned char> &keepDots) const;
+
+    private:
+        std::vector<MPoint> points;
+        std::vector<double> errors;
+
+        void build();
+};
+
+#endif
@@ -0,0 +1,57 @@
+//
+//  PickIndex.h
+//  MotionPath
+//
+//
+
+#ifndef PICKINDEX_H
+#define PICKINDEX_H
+
+#include <vector>
+
+// Viewport positions of the keys, tangent handles and frames of every path as they were last drawn in a panel,
+// bucketed in a uniform grid so a click only looks at the few items around the cursor.
+// Items come back in the order they were added: path by path, then by time
+class PickIndex
+{
+    public:
+        enum Type{
+            kKey = 0,
+            kTangent,
+            kFrame};
+
+        struct Item
+        {
+            Type type;
+            int path;
+            // key id for keys and tangents, frame for frames
+            int id;
+            // Keyframe::Tangent of a tangent handle
+            int tangent;
+            float x, y;
+        };
+
+        PickIndex(): width(0), height(0), columns(0), rows(0), built(false) {}
+
+        void begin(const int portWidth, const int portHeight);
+        void add(const Type type, const int path, const int id, const int tangent, const float x, const float y);
+        // buckets what was added since begin
+        void build();
+
+        bool isBuilt() const {return built;}
+        // items of the type within radius of the point, path -1 for any path
+        void query(const Type type, const int path, const double x, const double y, const double radius, std::vector<const Item*> &hits) const;
+
+    private:
+        int width, height;
+        int columns, rows;
+        bool built;
+        std::vector<Item> items;
+        // items of cell c are cellItems[cellStart[c]] up to cellItems[cellStart[c + 1]]
+        std::vector<unsigned int> cellStart;
+        std::vector<unsigned int> cellItems;
+
+        int cellOf(const double x, const double y) const;
+};
+
+#endif
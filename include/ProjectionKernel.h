@@ -0,0 +1,32 @@
+//
+//  ProjectionKernel.h
+//  MotionPath
+//
+//
+
+#ifndef PROJECTIONKERNEL_H
+#define PROJECTIONKERNEL_H
+
+// The float batch projection behind ScreenProjector, kept free of Maya so that it can be tested and benchmarked on its own.
+// Points are projected four at a time with SSE when the compiler has it and the rest goes through projectScalar,
+// both do the same operations in the same order so a point gives the same result whichever path it takes
+class ProjectionKernel
+{
+    public:
+        ProjectionKernel();
+
+        // row vector matrices like MMatrix, viewDepth is the column giving the distance in front of the camera
+        void set(const double viewProjection[4][4], const double viewDepth[4], const double halfWidth, const double halfHeight, const double minDepth);
+
+        // positions are xyz triplets, screen gets xy pairs and visible a 0/1 flag for each point
+        void project(const float *positions, const unsigned int count, float *screen, unsigned char *visible) const;
+        void projectScalar(const float *positions, const unsigned int first, const unsigned int last, float *screen, unsigned char *visible) const;
+
+    private:
+        float viewProjection[4][4];
+        float viewDepth[4];
+        float halfWidth, halfHeight;
+        float minDepth;
+};
+
+#endif
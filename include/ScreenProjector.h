@@ -0,0 +1,70 @@
+//
+//  ScreenProjector.h
+//  MotionPath
+//
+//
+
+#ifndef SCREENPROJECTOR_H
+#define SCREENPROJECTOR_H
+
+#include <maya/MPoint.h>
+#include <maya/MVector.h>
+#include <maya/MMatrix.h>
+
+#include <vector>
+
+#include "ProjectionKernel.h"
+
+class M3dView;
+
+namespace MHWRender
+{
+    class MFrameContext;
+}
+
+// World to viewport projection of a panel, set up once from its matrices and then used for every point drawn or picked.
+// Points behind the camera are reported as not visible, the same test the drawing code used to do point by point,
+// segments are clipped at the near plane and boxes can be tested against the frustum.
+// Arrays go through ProjectionKernel, four points at a time with SSE when the compiler has it
+class ScreenProjector
+{
+    public:
+        ScreenProjector();
+
+        // viewport 2.0 panel, coordinates relative to the viewport as MFrameContext::worldToViewport
+        void set(const MHWRender::MFrameContext &frameContext);
+        // legacy panel or tools, port coordinates as M3dView::worldToView
+        void set(const M3dView &view);
+
+        bool project(const MPoint &point, double &x, double &y) const;
+        bool project(const MVector &point, double &x, double &y) const {return project(MPoint(point), x, y);}
+
+        // clips the segment against the near plane of the camera before projecting it, false if it is all behind
+        bool projectSegment(const MPoint &start, const MPoint &end, MPoint &screenStart, MPoint &screenEnd) const;
+        // false when the box is entirely outside the side planes or behind the near plane
+        bool isBoxVisible(const MPoint &min, const MPoint &max) const;
+        // world units covered by a pixel at this point, 0 when it is behind the near plane
+        double pixelSize(const MPoint &point) const;
+
+        // positions are xyz triplets, screen gets xy pairs and visible a 0/1 flag for each point
+        void project(const float *positions, const unsigned int count, float *screen, unsigned char *visible) const;
+        void project(const std::vector<MVector> &points, std::vector<float> &screen, std::vector<unsigned char> &visible) const;
+
+    private:
+        // world to clip space and the view space depth row
+        double viewProjection[4][4];
+        double viewDepth[4];
+        ProjectionKernel kernel;
+        double halfWidth, halfHeight;
+        double nearDepth;
+        // pixels per view space unit at depth 1
+        double pixelScale;
+        // left, right, bottom, top and near, inside is where dot(plane, point) >= 0
+        double planes[5][4];
+
+        void setMatrices(const MMatrix &view, const MMatrix &projection, const double width, const double height, const double nearClip);
+        double depth(const MPoint &point) const;
+        void toScreen(const MPoint &point, MPoint &screen) const;
+};
+
+#endif
@@ -0,0 +1,42 @@
+//
+//  SegmentBounds.h
+//  MotionPath
+//
+//
+
+#ifndef SEGMENTBOUNDS_H
+#define SEGMENTBOUNDS_H
+
+#include <maya/MPoint.h>
+#include <maya/MPointArray.h>
+
+#include <utility>
+#include <vector>
+
+#include "ScreenProjector.h"
+
+// Two level bounding volume hierarchy over the frames of a path: a box around the whole path and one for every
+// chunk of consecutive frames. A chunk box also holds the first frame of the next chunk so the segment joining them
+// is never lost. Only the chunks that touch the view frustum need to be projected or drawn
+class SegmentBounds
+{
+    public:
+        typedef std::pair<unsigned int, unsigned int> Range;
+
+        static const unsigned int kChunkSize = 32;
+
+        SegmentBounds(): numPoints(0) {}
+
+        void clear();
+        void build(const MPointArray &points);
+
+        // first and last point index of the visible chunks, neighbouring chunks are merged in a single range
+        void visibleRanges(const ScreenProjector &projector, std::vector<Range> &ranges) const;
+
+    private:
+        unsigned int numPoints;
+        MPoint rootMin, rootMax;
+        std::vector<MPoint> chunkMin, chunkMax;
+};
+
+#endif
@@ -0,0 +1,90 @@
+//
+//  TransformChainEvaluator.h
+//  MotionPath
+//
+//
+
+#ifndef TRANSFORMCHAINEVALUATOR_H
+#define TRANSFORMCHAINEVALUATOR_H
+
+#include <vector>
+
+#include <maya/MMatrix.h>
+#include <maya/MVector.h>
+#include <maya/MEulerRotation.h>
+#include <maya/MObject.h>
+
+#include "AnimCurveEvaluator.h"
+
+class MDagPath;
+class MFnDependencyNode;
+class MPlug;
+class MTime;
+
+// Composes the parent matrix of a dag node from the anim curves of its ancestors without going through the DG.
+// Only plain transforms and joints whose channels are static or driven by time curves are supported,
+// anything else (constraints, expressions, custom transforms, instancing...) makes the snapshot fail
+// so that the caller can fall back to parentMatrix. Times are in seconds.
+class TransformChainEvaluator
+{
+    public:
+        TransformChainEvaluator();
+
+        void clear();
+        bool snapshot(const MDagPath &path);
+        bool isValid() const {return valid;}
+
+        MMatrix parentMatrix(const double time) const;
+        // pivots of the node itself, used when drawing the path around the rotate pivot
+        MVector rotatePivot(const double time) const;
+        MVector rotatePivotTranslate(const double time) const;
+
+        // the current values of the node channels that differ from its curves are overlaid at the given time,
+        // so that an ancestor moved without being keyed shows up in the matrices without touching the scene curves
+        bool overlayLiveValues(const MObject &node, const MTime &time);
+
+        // compares the composed matrix against the DG at the given times
+        bool validate(const MPlug &parentMatrixPlug, const std::vector<double> &times, const double tolerance = 1.0e-5) const;
+
+    private:
+        enum Channel{
+            kTranslate = 0,
+            kRotate = 3,
+            kScale = 6,
+            kShear = 9,
+            kRotatePivot = 12,
+            kRotatePivotTranslate = 15,
+            kScalePivot = 18,
+            kScalePivotTranslate = 21,
+            kRotateAxis = 24,
+            kJointOrient = 27,
+            kNumChannels = 30};
+
+        struct Node
+        {
+            MObject object;
+            bool joint;
+            bool inheritsTransform;
+            bool segmentScaleCompensate;
+            // the inverseScale of a joint is usually fed by the scale of the joint above it
+            bool inverseScaleFromParent;
+            MVector inverseScale;
+            MEulerRotation::RotationOrder rotateOrder;
+            MMatrix offsetParentMatrix;
+            AnimCurveEvaluator channels[kNumChannels];
+        };
+
+        bool valid;
+        // from the direct parent up to the root
+        std::vector<Node> nodes;
+        AnimCurveEvaluator pivots[6];
+
+        static bool snapshotNode(const MFnDependencyNode &nodeFn, const MObject &parent, Node &node);
+        static bool snapshotCompound(const MFnDependencyNode &nodeFn, const char *name, AnimCurveEvaluator *channels);
+        static bool isDestination(const MPlug &plug);
+
+        static MVector evaluateVector(const AnimCurveEvaluator *channels, const double time);
+        static MMatrix localMatrix(const Node &node, const double time, const MVector &parentScale, MVector &scale);
+};
+
+#endif
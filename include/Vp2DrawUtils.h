@@ -7,29 +7,36 @@
 #include <maya/MMatrix.h>
 #include <maya/MGlobal.h>
 #include <maya/MViewport2Renderer.h>
+#include <maya/MPointArray.h>
+#include <maya/MColorArray.h>
 
 #include <set>
 
 #include <Keyframe.h>
 #include <CameraCache.h>
+#include "ScreenProjector.h"
+#include "KeyGlyphCache.h"
 
 namespace VP2DrawUtils
 {
-	void drawLineStipple(const MVector &origin, const MVector &target, float lineWidth, const MColor &color, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext);
+	void drawLineStipple(const MVector &origin, const MVector &target, float lineWidth, const MColor &color, const ScreenProjector &projector, MHWRender::MUIDrawManager* drawManager);
 
-	void drawLine(const MVector &origin, const MVector &target, float lineWidth, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext);
+	void drawLine(const MVector &origin, const MVector &target, float lineWidth, const ScreenProjector &projector, MHWRender::MUIDrawManager* drawManager);
 
-	void drawLineWithColor(const MVector &origin, const MVector &target, float lineWidth, const MColor &color, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext);
+	void drawLineWithColor(const MVector &origin, const MVector &target, float lineWidth, const MColor &color, const ScreenProjector &projector, MHWRender::MUIDrawManager* drawManager);
 
-	void drawPoint(const MVector &point, float size, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext);
+	void drawPoint(const MVector &point, float size, const ScreenProjector &projector, MHWRender::MUIDrawManager* drawManager);
 
-	void drawPointWithColor(const MVector &point, float size, const MColor &color, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext);
+	void drawPointWithColor(const MVector &point, float size, const MColor &color, const ScreenProjector &projector, MHWRender::MUIDrawManager* drawManager);
 
-	void drawKeyFramePoints(KeyframeMap &keyframesCache, const float size, const double colorMultiplier, const int portWidth, const int portHeight, const bool showRotationKeyframes, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext);
+	void drawLineMesh(const MPointArray &points, const MColorArray *colors, const bool strip, float lineWidth, const MColor &color, MHWRender::MUIDrawManager* drawManager);
 
-	void drawKeyFrames(std::vector<Keyframe *> keys, const float size, const double colorMultiplier, const int portWidth, const int portHeight, const bool showRotationKeyframes, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext);
+	void drawPointMesh(const MPointArray &points, float size, const MColor &color, MHWRender::MUIDrawManager* drawManager);
+
+	// the glyphs of the keys come from the path's cache and are drawn as one mesh
+	void drawKeyFramePoints(KeyframeMap &keyframesCache, KeyGlyphCache &glyphCache, const float size, const double colorMultiplier, const bool showRotationKeyframes, const ScreenProjector &projector, MHWRender::MUIDrawManager* drawManager);
 
 	void convertWorldSpaceToCameraSpace(CameraCache* cachePtr, std::map<double, MPoint> &positions, std::map<double, MPoint> &screenSpacePositions, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext);
 
-	void drawFrameLabel(double frame, const MVector &framePos, M3dView &view, const double sizeOffset, const MColor &color, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext);
-}
\ No newline at end of file
+	void drawFrameLabel(double frame, const double viewX, const double viewY, const double sizeOffset, const MColor &color, MHWRender::MUIDrawManager* drawManager);
+}
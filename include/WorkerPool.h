@@ -0,0 +1,58 @@
+//
+//  WorkerPool.h
+//  MotionPath
+//
+//
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Small work stealing pool used to evaluate snapshotted path data off the main thread.
+// Tasks are handed out round robin, each worker drains its own queue from the back and steals
+// from the front of the others once it runs dry. The calling thread works too and run() only
+// returns once every task is done, tasks must not touch Maya's DG.
+class WorkerPool
+{
+    public:
+        typedef std::function<void()> Task;
+
+        WorkerPool();
+        ~WorkerPool();
+
+        // 0 means one thread per core
+        void setNumThreads(const int numThreads);
+        int getNumThreads() const {return static_cast<int>(queues.size());}
+
+        void run(std::vector<Task> &tasks);
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task*> tasks;
+        };
+
+        void start(const int numThreads);
+        void stop();
+        void workerLoop(const int index);
+        bool runOne(const int index);
+
+        std::vector<std::thread> threads;
+        std::vector<Queue*> queues;
+
+        std::mutex mutex;
+        std::condition_variable wakeCondition;
+        std::condition_variable doneCondition;
+        unsigned int generation;
+        int pending;
+        bool quit;
+};
+
+#endif
@@ -0,0 +1,441 @@
+//
+//  AnimCurveEvaluator.cpp
+//  MotionPath
+//
+//
+
+#include "AnimCurveEvaluator.h"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ANIMCURVEEVALUATOR_SSE
+#include <emmintrin.h>
+#endif
+
+AnimCurveEvaluator::AnimCurveEvaluator()
+{
+    clear();
+}
+
+void AnimCurveEvaluator::clear()
+{
+    valid = false;
+    constant = false;
+    constantValue = 0.0;
+    weighted = false;
+    keys.clear();
+    segments.clear();
+    preInfinity = kConstant;
+    postInfinity = kConstant;
+}
+
+void AnimCurveEvaluator::setConstant(const double value)
+{
+    clear();
+    constant = true;
+    constantValue = value;
+    valid = true;
+}
+
+bool AnimCurveEvaluator::buildSegment(const size_t index)
+{
+    const Key &k0 = keys[index];
+    const Key &k1 = keys[index + 1];
+    Segment &s = segments[index];
+
+    s.startTime = k0.time;
+    s.endTime = k1.time;
+    s.startValue = k0.value;
+    s.endValue = k1.value;
+    s.step = k0.stepOut;
+    s.stepNext = k0.stepNextOut;
+    s.weighted = weighted;
+
+    double dt = s.endTime - s.startTime;
+    if (dt <= 0.0)
+        return false;
+
+    if (!weighted)
+    {
+        // hermite segment, only the slope of the tangents matters and the tangent lengths are the segment length
+        if (std::fabs(k0.outX) < 1e-12 || std::fabs(k1.inX) < 1e-12)
+            return false;
+
+        double m0 = k0.outY / k0.outX * dt;
+        double m1 = k1.inY / k1.inX * dt;
+        s.y[0] = 2.0 * k0.value + m0 - 2.0 * k1.value + m1;
+        s.y[1] = -3.0 * k0.value - 2.0 * m0 + 3.0 * k1.value - m1;
+        s.y[2] = m0;
+        s.y[3] = k0.value;
+    }
+    else
+    {
+        // bezier segment, control points sit a third of the tangent away from the keys
+        double x1 = k0.time + k0.outX / 3.0;
+        double x2 = k1.time - k1.inX / 3.0;
+        double y1 = k0.value + k0.outY / 3.0;
+        double y2 = k1.value - k1.inY / 3.0;
+
+        // time can not go backwards within a segment
+        x1 = std::min(std::max(x1, s.startTime), s.endTime);
+        x2 = std::min(std::max(x2, s.startTime), s.endTime);
+
+        s.x[0] = -s.startTime + 3.0 * x1 - 3.0 * x2 + s.endTime;
+        s.x[1] = 3.0 * s.startTime - 6.0 * x1 + 3.0 * x2;
+        s.x[2] = -3.0 * s.startTime + 3.0 * x1;
+        s.x[3] = s.startTime;
+
+        s.y[0] = -k0.value + 3.0 * y1 - 3.0 * y2 + k1.value;
+        s.y[1] = 3.0 * k0.value - 6.0 * y1 + 3.0 * y2;
+        s.y[2] = -3.0 * k0.value + 3.0 * y1;
+        s.y[3] = k0.value;
+    }
+
+    return true;
+}
+
+bool AnimCurveEvaluator::setKeys(const std::vector<Key> &keys, const bool weighted, const Infinity preInfinity, const Infinity postInfinity)
+{
+    clear();
+
+    if (keys.empty())
+        return false;
+
+    this->keys = keys;
+    this->weighted = weighted;
+    this->preInfinity = preInfinity;
+    this->postInfinity = postInfinity;
+    firstKey = keys.front();
+    lastKey = keys.back();
+
+    if (keys.size() == 1)
+    {
+        // a single key only differs from a constant with linear infinities
+        constant = preInfinity != kLinear && postInfinity != kLinear;
+        constantValue = firstKey.value;
+        valid = true;
+        return true;
+    }
+
+    segments.resize(keys.size() - 1);
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        if (!buildSegment(i))
+            return false;
+    }
+
+    valid = true;
+    return true;
+}
+
+bool AnimCurveEvaluator::overlayKey(const double time, const double value)
+{
+    if (!valid)
+        return false;
+
+    // a plug without a curve only has its current value
+    if (keys.empty())
+    {
+        setConstant(value);
+        return true;
+    }
+
+    std::vector<Key> newKeys(keys);
+    size_t index = 0;
+    while (index < newKeys.size() && newKeys[index].time < time - 1e-9)
+        ++index;
+
+    if (index < newKeys.size() && std::fabs(newKeys[index].time - time) <= 1e-9)
+    {
+        newKeys[index].value = value;
+    }
+    else
+    {
+        // the new key gets a smooth tangent through its neighbours, flat at the ends of the curve
+        Key key;
+        key.time = time;
+        key.value = value;
+
+        const Key *prev = index > 0 ? &newKeys[index - 1] : NULL;
+        const Key *next = index < newKeys.size() ? &newKeys[index] : NULL;
+        double slope = prev && next ? (next->value - prev->value) / (next->time - prev->time) : 0.0;
+
+        key.inX = prev ? time - prev->time : (next ? next->time - time : 1.0);
+        key.outX = next ? next->time - time : key.inX;
+        key.inY = slope * key.inX;
+        key.outY = slope * key.outX;
+        key.stepOut = prev ? prev->stepOut : false;
+        key.stepNextOut = prev ? prev->stepNextOut : false;
+        key.fixedTangents = false;
+
+        newKeys.insert(newKeys.begin() + index, key);
+    }
+
+    Infinity pre = preInfinity, post = postInfinity;
+    return setKeys(newKeys, weighted, pre, post);
+}
+
+int AnimCurveEvaluator::findKey(const double time) const
+{
+    size_t index = 0;
+    while (index < keys.size() && keys[index].time < time - 1e-9)
+        ++index;
+
+    if (index == keys.size() || std::fabs(keys[index].time - time) > 1e-9)
+        return -1;
+    return static_cast<int>(index);
+}
+
+bool AnimCurveEvaluator::canOffsetKey(const double time) const
+{
+    if (!valid)
+        return false;
+
+    int index = findKey(time);
+    if (index == -1)
+        return false;
+
+    // the tangents of the neighbours look at the key too (linear, spline, clamped, auto...)
+    int first = index > 0 ? index - 1 : index;
+    int last = index + 1 < static_cast<int>(keys.size()) ? index + 1 : index;
+    for (int i = first; i <= last; ++i)
+    {
+        if (!keys[i].fixedTangents)
+            return false;
+    }
+
+    return true;
+}
+
+bool AnimCurveEvaluator::offsetKey(const double time, const double offset)
+{
+    if (!canOffsetKey(time))
+        return false;
+
+    size_t index = static_cast<size_t>(findKey(time));
+    keys[index].value += offset;
+    firstKey = keys.front();
+    lastKey = keys.back();
+    if (keys.size() == 1)
+        constantValue = firstKey.value;
+
+    // only the segments on either side of the key change
+    if (index > 0)
+        buildSegment(index - 1);
+    if (index < segments.size())
+        buildSegment(index);
+
+    return true;
+}
+
+double AnimCurveEvaluator::solveBezierTime(const double *x, const double time)
+{
+    // newton iterations starting from the linear guess, falling back to bisection when they misbehave
+    double span = x[0] + x[1] + x[2];
+    double s = span != 0.0 ? (time - x[3]) / span : 0.0;
+    s = std::min(std::max(s, 0.0), 1.0);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        double value = ((x[0] * s + x[1]) * s + x[2]) * s + x[3] - time;
+        if (std::fabs(value) < 1e-12)
+            return s;
+
+        double derivative = (3.0 * x[0] * s + 2.0 * x[1]) * s + x[2];
+        if (std::fabs(derivative) < 1e-12)
+            break;
+
+        double next = s - value / derivative;
+        if (next < 0.0 || next > 1.0)
+            break;
+        s = next;
+    }
+
+    double low = 0.0, high = 1.0;
+    s = 0.5;
+    for (int i = 0; i < 60; ++i)
+    {
+        double value = ((x[0] * s + x[1]) * s + x[2]) * s + x[3];
+        if (value < time)
+            low = s;
+        else
+            high = s;
+        s = 0.5 * (low + high);
+    }
+
+    return s;
+}
+
+double AnimCurveEvaluator::evaluateSegment(const Segment &segment, const double time) const
+{
+    if (segment.step)
+        return segment.startValue;
+
+    if (segment.stepNext)
+        return time > segment.startTime ? segment.endValue : segment.startValue;
+
+    double u;
+    if (segment.weighted)
+        u = solveBezierTime(segment.x, time);
+    else
+        u = (time - segment.startTime) / (segment.endTime - segment.startTime);
+
+    return ((segment.y[0] * u + segment.y[1]) * u + segment.y[2]) * u + segment.y[3];
+}
+
+int AnimCurveEvaluator::findSegment(const double time) const
+{
+    int low = 0;
+    int high = static_cast<int>(segments.size()) - 1;
+    while (low < high)
+    {
+        int mid = (low + high + 1) / 2;
+        if (segments[mid].startTime <= time)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+
+    return low;
+}
+
+double AnimCurveEvaluator::evaluateInRange(const double time) const
+{
+    if (segments.empty())
+        return firstKey.value;
+
+    if (time >= lastKey.time)
+        return lastKey.value;
+
+    return evaluateSegment(segments[findSegment(time)], time);
+}
+
+double AnimCurveEvaluator::evaluateInfinity(const double time) const
+{
+    bool before = time < firstKey.time;
+    Infinity mode = before ? preInfinity : postInfinity;
+
+    double range = lastKey.time - firstKey.time;
+    if (mode != kLinear && (mode == kConstant || range <= 0.0))
+        return before ? firstKey.value : lastKey.value;
+
+    if (mode == kLinear)
+    {
+        if (before)
+        {
+            if (std::fabs(firstKey.inX) < 1e-12)
+                return firstKey.value;
+            return firstKey.value - firstKey.inY / firstKey.inX * (firstKey.time - time);
+        }
+
+        if (std::fabs(lastKey.outX) < 1e-12)
+            return lastKey.value;
+        return lastKey.value + lastKey.outY / lastKey.outX * (time - lastKey.time);
+    }
+
+    double cycles = std::floor((time - firstKey.time) / range);
+    double localTime = time - cycles * range;
+
+    if (mode == kOscillate)
+    {
+        if (static_cast<long long>(std::fabs(cycles)) % 2 == 1)
+            localTime = lastKey.time - (localTime - firstKey.time);
+        return evaluateInRange(localTime);
+    }
+
+    double value = evaluateInRange(localTime);
+    if (mode == kCycleRelative)
+        value += cycles * (lastKey.value - firstKey.value);
+    return value;
+}
+
+double AnimCurveEvaluator::evaluate(const double time) const
+{
+    if (constant)
+        return constantValue;
+
+    if (time < firstKey.time || time > lastKey.time)
+        return evaluateInfinity(time);
+
+    return evaluateInRange(time);
+}
+
+void AnimCurveEvaluator::evaluateRange(const double startTime, const double step, const int count, double *values) const
+{
+    if (constant)
+    {
+        std::fill(values, values + count, constantValue);
+        return;
+    }
+
+    if (segments.empty() || step <= 0.0)
+    {
+        for (int i = 0; i < count; ++i)
+            values[i] = evaluate(startTime + i * step);
+        return;
+    }
+
+    int current = -1;
+    int lastSegment = static_cast<int>(segments.size()) - 1;
+    for (int i = 0; i < count; ++i)
+    {
+        double time = startTime + i * step;
+        if (time < firstKey.time || time >= lastKey.time)
+        {
+            values[i] = evaluate(time);
+            continue;
+        }
+
+        if (current == -1)
+            current = findSegment(time);
+        while (current < lastSegment && segments[current].endTime <= time)
+            ++current;
+
+        const Segment &segment = segments[current];
+        if (segment.weighted || segment.step || segment.stepNext)
+        {
+            values[i] = evaluateSegment(segment, time);
+            continue;
+        }
+
+        // every sample left in this hermite segment goes through the polynomial in one go
+        int end = i + 1;
+        while (end < count && startTime + end * step < segment.endTime)
+            ++end;
+
+        evaluateHermite(segment, startTime, step, i, end, values);
+        i = end - 1;
+    }
+}
+
+void AnimCurveEvaluator::evaluateHermite(const Segment &segment, const double startTime, const double step, const int first, const int end, double *values)
+{
+    // same operations in the same order as evaluateSegment so that both give the same bits
+    double duration = segment.endTime - segment.startTime;
+    int i = first;
+
+#ifdef ANIMCURVEEVALUATOR_SSE
+    const __m128d start = _mm_set1_pd(startTime);
+    const __m128d stride = _mm_set1_pd(step);
+    const __m128d segmentStart = _mm_set1_pd(segment.startTime);
+    const __m128d segmentDuration = _mm_set1_pd(duration);
+    const __m128d y0 = _mm_set1_pd(segment.y[0]), y1 = _mm_set1_pd(segment.y[1]), y2 = _mm_set1_pd(segment.y[2]), y3 = _mm_set1_pd(segment.y[3]);
+
+    for (; i + 2 <= end; i += 2)
+    {
+        __m128d index = _mm_setr_pd(static_cast<double>(i), static_cast<double>(i + 1));
+        __m128d time = _mm_add_pd(start, _mm_mul_pd(index, stride));
+        __m128d u = _mm_div_pd(_mm_sub_pd(time, segmentStart), segmentDuration);
+        __m128d value = _mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_mul_pd(y0, u), y1), u), y2), u), y3);
+        _mm_storeu_pd(values + i, value);
+    }
+#endif
+
+    for (; i < end; ++i)
+    {
+        double u = (startTime + i * step - segment.startTime) / duration;
+        values[i] = ((segment.y[0] * u + segment.y[1]) * u + segment.y[2]) * u + segment.y[3];
+    }
+}
@@ -0,0 +1,221 @@
+//
+//  AnimCurveSnapshot.cpp
+//  MotionPath
+//
+//
+
+// The Maya side of AnimCurveEvaluator, reading the curves and checking the snapshot against the DG.
+// Kept apart so that the evaluation itself builds without Maya.
+
+#include "AnimCurveEvaluator.h"
+
+#include <maya/MFnAnimCurve.h>
+#include <maya/MPlug.h>
+#include <maya/MPlugArray.h>
+#include <maya/MObject.h>
+#include <maya/MFn.h>
+#include <maya/MTime.h>
+#include <maya/MDGContext.h>
+#include <maya/MAnimControl.h>
+
+#include <cmath>
+#include <algorithm>
+
+static bool isDestination(const MPlug &plug)
+{
+    MPlugArray sources;
+    plug.connectedTo(sources, true, false);
+    return sources.length() > 0;
+}
+
+// tangents that stay where they are when the key values change
+static bool isFixedTangent(const MFnAnimCurve::TangentType type)
+{
+    return type == MFnAnimCurve::kTangentFixed || type == MFnAnimCurve::kTangentFlat || type == MFnAnimCurve::kTangentStep || type == MFnAnimCurve::kTangentStepNext;
+}
+
+static AnimCurveEvaluator::Infinity infinityFromCurve(const MFnAnimCurve::InfinityType type)
+{
+    switch (type)
+    {
+        case MFnAnimCurve::kLinear:
+            return AnimCurveEvaluator::kLinear;
+        case MFnAnimCurve::kCycle:
+            return AnimCurveEvaluator::kCycle;
+        case MFnAnimCurve::kCycleRelative:
+            return AnimCurveEvaluator::kCycleRelative;
+        case MFnAnimCurve::kOscillate:
+            return AnimCurveEvaluator::kOscillate;
+        default:
+            return AnimCurveEvaluator::kConstant;
+    }
+}
+
+bool AnimCurveEvaluator::snapshot(const MFnAnimCurve &curve)
+{
+    clear();
+
+    MFnAnimCurve::AnimCurveType type = curve.animCurveType();
+    if (type != MFnAnimCurve::kAnimCurveTL && type != MFnAnimCurve::kAnimCurveTA && type != MFnAnimCurve::kAnimCurveTU)
+        return false;
+
+    unsigned int numKeys = curve.numKeys();
+    if (numKeys == 0)
+        return false;
+
+    std::vector<Key> keys(numKeys);
+    for (unsigned int i = 0; i < numKeys; ++i)
+    {
+        Key &key = keys[i];
+        key.time = curve.time(i).as(MTime::kSeconds);
+        key.value = curve.value(i);
+
+#if defined(MAYA2018)
+		MFnAnimCurve::TangentValue x, y;
+#else
+        float x, y;
+#endif
+        curve.getTangent(i, x, y, true);
+        key.inX = x;
+        key.inY = y;
+        curve.getTangent(i, x, y, false);
+        key.outX = x;
+        key.outY = y;
+
+        MFnAnimCurve::TangentType inType = curve.inTangentType(i);
+        MFnAnimCurve::TangentType outType = curve.outTangentType(i);
+        key.stepOut = outType == MFnAnimCurve::kTangentStep;
+        key.stepNextOut = outType == MFnAnimCurve::kTangentStepNext;
+        key.fixedTangents = isFixedTangent(inType) && isFixedTangent(outType);
+    }
+
+    return setKeys(keys, curve.isWeighted(), infinityFromCurve(curve.preInfinityType()), infinityFromCurve(curve.postInfinityType()));
+}
+
+bool AnimCurveEvaluator::snapshot(const MPlug &plug)
+{
+    clear();
+
+    // a child of a driven compound (i.e. translate fed by a motionPath node) has no connection of its own
+    if (plug.isChild() && isDestination(plug.parent()))
+        return false;
+
+    if (!isDestination(plug))
+    {
+        // nothing driving the plug, the value should be the same at any time
+        setConstant(plug.asDouble());
+        if (!validateConstant(plug))
+        {
+            clear();
+            return false;
+        }
+        return true;
+    }
+
+    MPlugArray sources;
+    plug.connectedTo(sources, true, false);
+
+    MObject node = sources[0].node();
+    if (!node.hasFn(MFn::kAnimCurve))
+        return false;
+
+    MFnAnimCurve curve(node);
+
+    // a time curve with its input connected is driven by something else than the scene time
+    MPlug inputPlug = curve.findPlug("input");
+    MPlugArray inputSources;
+    if (!inputPlug.isNull() && inputPlug.connectedTo(inputSources, true, false) && inputSources.length() > 0)
+        return false;
+
+    if (!snapshot(curve))
+        return false;
+
+    if (!validate(curve))
+    {
+        clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool AnimCurveEvaluator::validate(const MFnAnimCurve &curve, const double tolerance) const
+{
+    if (!valid)
+        return false;
+
+    unsigned int numKeys = curve.numKeys();
+    if (numKeys == 0)
+        return false;
+
+    // a handful of samples on each segment plus a few in the infinities, capped so that dense curves stay cheap
+    std::vector<double> times;
+    unsigned int stride = numKeys > 16 ? numKeys / 16 : 1;
+    for (unsigned int i = 0; i < numKeys; i += stride)
+    {
+        double t0 = curve.time(i).as(MTime::kSeconds);
+        times.push_back(t0);
+        if (i + 1 < numKeys)
+        {
+            double t1 = curve.time(i + 1).as(MTime::kSeconds);
+            times.push_back(t0 + (t1 - t0) * 0.25);
+            times.push_back(t0 + (t1 - t0) * 0.5);
+            times.push_back(t0 + (t1 - t0) * 0.8);
+        }
+    }
+
+    double first = curve.time(0).as(MTime::kSeconds);
+    double last = curve.time(numKeys - 1).as(MTime::kSeconds);
+    double range = last - first > 0.0 ? last - first : 1.0;
+    times.push_back(last);
+    times.push_back(first - range * 0.37);
+    times.push_back(last + range * 1.63);
+
+    for (size_t i = 0; i < times.size(); ++i)
+    {
+        double expected = curve.evaluate(MTime(times[i], MTime::kSeconds));
+        double value = evaluate(times[i]);
+        if (std::fabs(expected - value) > tolerance * std::max(1.0, std::fabs(expected)))
+            return false;
+    }
+
+    return true;
+}
+
+bool AnimCurveEvaluator::validateConstant(const MPlug &plug, const double tolerance) const
+{
+    if (!valid || !constant)
+        return false;
+
+    // the ends of the playback range, anything that slipped through the connection checks shows up there
+    MTime times[2] = {MAnimControl::minTime(), MAnimControl::maxTime()};
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        double expected = plug.asDouble(MDGContext(times[i]));
+        if (std::fabs(expected - constantValue) > tolerance * std::max(1.0, std::fabs(expected)))
+            return false;
+    }
+
+    return true;
+}
+
+bool AnimCurveEvaluator::overlayLiveValue(const MPlug &plug, const MTime &time)
+{
+    if (!valid)
+        return false;
+
+    // Maya against Maya, our own evaluation can be off in the last bits and that is no reason for a key
+    double curveValue = constantValue;
+    MPlugArray sources;
+    plug.connectedTo(sources, true, false);
+    if (sources.length() > 0 && sources[0].node().hasFn(MFn::kAnimCurve))
+        curveValue = MFnAnimCurve(sources[0].node()).evaluate(time);
+    else if (!constant)
+        return false;
+
+    double liveValue = plug.asDouble();
+    if (std::fabs(liveValue - curveValue) <= 1.0e-10)
+        return false;
+
+    return overlayKey(time.as(MTime::kSeconds), liveValue);
+}
@@ -20,6 +20,9 @@ BufferPath::BufferPath()
 void BufferPath::drawFrames(const double startTime, const double endTime, const MColor &curveColor, CameraCache* cachePtr, const MMatrix &currentCameraMatrix, M3dView &view, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
 {
     int frameSize = frames.size();
+    
+    std::vector<MVector> segments;
+    std::vector<unsigned char> lastSegment;
 
     if (GlobalSettings::motionPathDrawMode == GlobalSettings::kCameraSpace)
         cachePtr->ensureMatricesAtTime(startTime);
@@ -40,27 +43,58 @@ void BufferPath::drawFrames(const double startTime, const double endTime, const
             pos2 = MPoint(pos2) * cachePtr->matrixCache[i-1] * currentCameraMatrix;
         }
         
+        if (drawManager)
+        {
+            segments.push_back(pos2);
+            segments.push_back(pos1);
+            lastSegment.push_back(i == endTime || i == minTime + frameSize - 1);
+            continue;
+        }
+        
 		if (GlobalSettings::showPath)
-		{
-			if (drawManager)
-				VP2DrawUtils::drawLineWithColor(pos1, pos2, GlobalSettings::pathSize, curveColor, currentCameraMatrix, drawManager, frameContext);
-			else
-				drawUtils::drawLineWithColor(pos1, pos2, GlobalSettings::pathSize, curveColor);
-		}
+			drawUtils::drawLineWithColor(pos1, pos2, GlobalSettings::pathSize, curveColor);
         
-		if (drawManager)
-			VP2DrawUtils::drawPointWithColor(pos2, GlobalSettings::frameSize, curveColor, currentCameraMatrix, drawManager, frameContext);
-		else
-			drawUtils::drawPointWithColor(pos2, GlobalSettings::frameSize, curveColor);
+		drawUtils::drawPointWithColor(pos2, GlobalSettings::frameSize, curveColor);
 
         if (i == endTime || i == minTime + frameSize - 1)
-		{
-			if (drawManager)
-				VP2DrawUtils::drawPointWithColor(pos1, GlobalSettings::frameSize, curveColor, currentCameraMatrix, drawManager, frameContext);
-			else
-				drawUtils::drawPointWithColor(pos1, GlobalSettings::frameSize, curveColor);
-		}
+			drawUtils::drawPointWithColor(pos1, GlobalSettings::frameSize, curveColor);
 	}
+    
+    if (!drawManager || segments.empty())
+        return;
+    
+    //both ends of every segment are projected in one go, a segment crossing the near plane is clipped against it
+    std::vector<float> screen;
+    std::vector<unsigned char> visible;
+    GlobalSettings::screenProjector.project(segments, screen, visible);
+    
+    drawManager->setColor(curveColor);
+    drawManager->setLineWidth(GlobalSettings::pathSize);
+    for (unsigned int i = 0; i < lastSegment.size(); ++i)
+    {
+        MPoint start(screen[i * 4], screen[i * 4 + 1]);
+        MPoint end(screen[i * 4 + 2], screen[i * 4 + 3]);
+        bool startVisible = visible[i * 2] != 0;
+        bool endVisible = visible[i * 2 + 1] != 0;
+        
+        if (GlobalSettings::showPath)
+        {
+            if (startVisible && endVisible)
+                drawManager->line2d(end, start);
+            else
+            {
+                MPoint clippedStart, clippedEnd;
+                if (GlobalSettings::screenProjector.projectSegment(segments[i * 2], segments[i * 2 + 1], clippedStart, clippedEnd))
+                    drawManager->line2d(clippedEnd, clippedStart);
+            }
+        }
+        
+        if (startVisible)
+            drawManager->circle2d(start, GlobalSettings::frameSize / 2, true);
+        
+        if (lastSegment[i] && endVisible)
+            drawManager->circle2d(end, GlobalSettings::frameSize / 2, true);
+    }
 }
 
 void BufferPath::drawKeyFrames(const double startTime, const double endTime, const MColor &curveColor, CameraCache* cachePtr, const MMatrix &currentCameraMatrix, M3dView &view, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
@@ -78,7 +112,7 @@ void BufferPath::drawKeyFrames(const double startTime, const double endTime, con
             }
             
 			if (drawManager)
-				VP2DrawUtils::drawPointWithColor(pos, GlobalSettings::frameSize, curveColor, GlobalSettings::cameraMatrix, drawManager, frameContext);
+				VP2DrawUtils::drawPointWithColor(pos, GlobalSettings::frameSize, curveColor, GlobalSettings::screenProjector, drawManager);
 			else
 				drawUtils::drawPointWithColor(pos, GlobalSettings::frameSize * 1.5, curveColor);
         }
@@ -133,7 +167,7 @@ void BufferPath::draw(M3dView &view, CameraCache* cachePtr, MHWRender::MUIDrawMa
         }
         
 		if (drawManager)
-			VP2DrawUtils::drawPointWithColor(pos, GlobalSettings::frameSize, curveColor, GlobalSettings::cameraMatrix, drawManager, frameContext);
+			VP2DrawUtils::drawPointWithColor(pos, GlobalSettings::frameSize, curveColor, GlobalSettings::screenProjector, drawManager);
 		else
 			drawUtils::drawPointWithColor(pos, GlobalSettings::frameSize * 1.6, currentColor);
     }
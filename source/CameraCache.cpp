@@ -13,7 +13,6 @@
 
 #include "CameraCache.h"
 #include "GlobalSettings.h"
-#include "animCurveUtils.h"
 
 
 
@@ -21,6 +20,7 @@ CameraCache::CameraCache()
 {
     caching = false;
     initialized = false;
+    nativeCamera = false;
 }
 
 void CameraCache::initialize(const MObject &camera)
@@ -33,20 +33,27 @@ void CameraCache::initialize(const MObject &camera)
     caching = false;
     initialized = true;
     
-    MDagPath dagPath;
-    MDagPath::getAPathTo(camera, dagPath);
-    dagPath.pop(1);
+    MDagPath::getAPathTo(camera, cameraPath);
     
-    MFnDependencyNode transformFn(dagPath.node());
-    txPlug = transformFn.findPlug("translateX");
-    tyPlug = transformFn.findPlug("translateY");
-    tzPlug = transformFn.findPlug("translateZ");
+    MDagPath transformPath(cameraPath);
+    transformPath.pop(1);
+    transformObject = transformPath.node();
     
-    rxPlug = transformFn.findPlug("rotateX");
-    ryPlug = transformFn.findPlug("rotateY");
-    rzPlug = transformFn.findPlug("rotateZ");
+    nativeCamera = false;
 }
 
+MMatrix CameraCache::getInverseMatrixAtTime(const double time)
+{
+    if (nativeCamera)
+        return chainEvaluator.parentMatrix(MTime(time, MTime::uiUnit()).as(MTime::kSeconds)).inverse();
+    
+    MTime evalTime(time, MTime::uiUnit());
+    MDGContext context(evalTime);
+    
+    MObject val;
+    worldMatrixPlug.getValue(val, context);
+    return MFnMatrixData(val).matrix().inverse();
+}
 
 void CameraCache::cacheCamera()
 {
@@ -63,79 +70,27 @@ void CameraCache::cacheCamera()
     
     caching = true;
     
-    MTime currentTime = MAnimControl::currentTime();
-    
-    MStatus xStatus, yStatus, zStatus, rotxStatus, rotyStatus, rotzStatus;
-    MFnAnimCurve curveX(txPlug, &xStatus);
-	MFnAnimCurve curveY(tyPlug, &yStatus);
-	MFnAnimCurve curveZ(tzPlug, &zStatus);
-    MFnAnimCurve curveRotX(rxPlug, &rotxStatus);
-	MFnAnimCurve curveRotY(ryPlug, &rotyStatus);
-	MFnAnimCurve curveRotZ(rzPlug, &rotzStatus);
-    
-    double newXValue, newYValue, newZValue, newRotXValue, newRotYValue, newRotZValue;
-    double oldXValue, oldYValue, oldZValue, oldRotXValue, oldRotYValue, oldRotZValue;
-    int newKeyX, newKeyY, newKeyZ, newKeyRotX, newKeyRotY, newKeyRotZ;
-    int oldKeyX, oldKeyY, oldKeyZ, oldKeyRotX, oldKeyRotY, oldKeyRotZ;
-	bool xUpdated = (xStatus == MS::kSuccess), yUpdated = (yStatus == MS::kSuccess), zUpdated = (zStatus == MS::kSuccess);
-	bool rotxUpdated = (rotxStatus == MS::kSuccess), rotyUpdated = (rotyStatus == MS::kSuccess), rotzUpdated = (rotzStatus == MS::kSuccess);
-    if (xStatus != MS::kNotFound)
-        xUpdated = animCurveUtils::updateCurve(txPlug, curveX, currentTime, oldXValue, newXValue, newKeyX, oldKeyX);
-    if (yStatus != MS::kNotFound)
-        yUpdated = animCurveUtils::updateCurve(tyPlug, curveY, currentTime, oldYValue, newYValue, newKeyY, oldKeyY);
-    if (zStatus != MS::kNotFound)
-        zUpdated = animCurveUtils::updateCurve(tzPlug, curveZ, currentTime, oldZValue, newZValue, newKeyZ, oldKeyZ);
-    if (rotxStatus != MS::kNotFound)
-        rotxUpdated = animCurveUtils::updateCurve(rxPlug, curveRotX, currentTime, oldRotXValue, newRotXValue, newKeyRotX, oldKeyRotX);
-    if (rotyStatus != MS::kNotFound)
-        rotyUpdated = animCurveUtils::updateCurve(ryPlug, curveRotY, currentTime, oldRotYValue, newRotYValue, newKeyRotY, oldKeyRotY);
-    if (rotzStatus != MS::kNotFound)
-        rotzUpdated = animCurveUtils::updateCurve(rzPlug, curveRotZ, currentTime, oldRotZValue, newRotZValue, newKeyRotZ, oldKeyRotZ);
-    
-    matrixCache.clear();
-    
-    for (double i = startFrame; i <= endFrame; ++i)
+    //the camera world matrix is the parent matrix of its shape, so the camera chain can be composed like the one of a path.
+    //Values that were not keyed yet are overlaid on our snapshot rather than keyed on the scene curves,
+    //when going through the DG they only show up at the current frame
+    nativeCamera = chainEvaluator.snapshot(cameraPath);
+    if (nativeCamera)
     {
-        MTime evalTime(i, MTime::uiUnit());
-        MDGContext context(evalTime);
+        std::vector<double> times;
+        if (startFrame != currentFrame)
+            times.push_back(MTime(startFrame, MTime::uiUnit()).as(MTime::kSeconds));
+        if (endFrame != currentFrame)
+            times.push_back(MTime(endFrame, MTime::uiUnit()).as(MTime::kSeconds));
         
-        MObject val;
-        worldMatrixPlug.getValue(val, context);
-        matrixCache[i] = MFnMatrixData(val).matrix().inverse();
+        nativeCamera = chainEvaluator.validate(worldMatrixPlug, times);
+        if (nativeCamera)
+            chainEvaluator.overlayLiveValues(transformObject, MAnimControl::currentTime().as(MTime::kSeconds));
     }
     
-    //restoring the previous values if a keyframe was not actually set by the user
-    if (xUpdated && xStatus != MS::kNotFound)
-    {
-        animCurveUtils::restoreCurve(curveX, currentTime, oldXValue, newKeyX, oldKeyX);
-        txPlug.setValue(newXValue);
-    }
-    if (yUpdated && yStatus != MS::kNotFound)
-    {
-        animCurveUtils::restoreCurve(curveY, currentTime, oldYValue, newKeyY, oldKeyY);
-        tyPlug.setValue(newYValue);
-    }
-    if (zUpdated && zStatus != MS::kNotFound )
-    {
-        animCurveUtils::restoreCurve(curveZ, currentTime, oldZValue, newKeyZ, oldKeyZ);
-        tzPlug.setValue(newZValue);
-    }
+    matrixCache.clear();
     
-    if (rotxUpdated && rotxStatus != MS::kNotFound)
-    {
-        animCurveUtils::restoreCurve(curveRotX, currentTime, oldRotXValue, newKeyRotX, oldKeyRotX);
-        rxPlug.setValue(newRotXValue);
-    }
-    if (rotyUpdated && rotyStatus != MS::kNotFound)
-    {
-        animCurveUtils::restoreCurve(curveRotY, currentTime, oldRotYValue, newKeyRotY, oldKeyRotY);
-        ryPlug.setValue(newRotYValue);
-    }
-    if (rotzUpdated && rotzStatus != MS::kNotFound )
-    {
-        animCurveUtils::restoreCurve(curveRotZ, currentTime, oldRotZValue, newKeyRotZ, oldKeyRotZ);
-        rzPlug.setValue(newRotZValue);
-    }
+    for (double i = startFrame; i <= endFrame; ++i)
+        matrixCache[i] = getInverseMatrixAtTime(i);
     
     caching = false;
 }
@@ -158,14 +113,7 @@ void CameraCache::checkRangeIsCached()
     for (double i = startFrame; i <= endFrame; ++i)
     {
         if (matrixCache.find(i) == matrixCache.end())
-        {
-            MTime evalTime(i, MTime::uiUnit());
-            MDGContext context(evalTime);
-            
-            MObject val;
-            worldMatrixPlug.getValue(val, context);
-            matrixCache[i] = MFnMatrixData(val).matrix().inverse();
-        }
+            matrixCache[i] = getInverseMatrixAtTime(i);
     }
     caching = false;
 }
@@ -177,14 +125,6 @@ void CameraCache::ensureMatricesAtTime(const double time, const bool force)
         if (worldMatrixPlug.isNull())
             return;
         
-        std::string name = worldMatrixPlug.name().asChar();
-        
-        MTime evalTime(time, MTime::uiUnit());
-        
-        MDGContext context(evalTime);
-        
-        MObject val;
-        worldMatrixPlug.getValue(val, context);
-        matrixCache[time] = MFnMatrixData(val).matrix().inverse();
+        matrixCache[time] = getInverseMatrixAtTime(time);
     }
 }
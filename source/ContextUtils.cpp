@@ -8,10 +8,13 @@
 
 #include "ContextUtils.h"
 #include "Keyframe.h"
+#include "PickIndex.h"
 
 #include <maya/MPoint.h>
 #include <maya/MIntArray.h>
 
+extern MotionPathManager mpManager;
+
 bool contextUtils::worldCameraSpaceToWorldSpace(MVector &position, M3dView &view, const double time, const MMatrix &inverseCameraMatrix, MotionPathManager &mpManager)
 {
     CameraCache * cachePtr = mpManager.getCameraCachePtrFromView(view);
@@ -48,197 +51,72 @@ MVector contextUtils::getWorldPositionFromProjPoint(const MVector &pointToMove,
     return (endPoint - startPoint) + pointToMove;
 }
 
-int contextUtils::processCurveHits(M3dView &view, CameraCache *cachePtr, MotionPathManager &mpManager)
+// hits are tested on the cpu against the pick index the last draw of the view left behind, the same for both renderers
+
+static double pickRadius(const PickIndex::Type type)
 {
-    GLuint glSelectionBuffer[256];
-    view.beginSelect(glSelectionBuffer, 256);
-    view.initNames();
-    
-    mpManager.drawCurvesForSelection(view, cachePtr);
-    
-    GLint hits = view.endSelect();
-    if (hits == 0)  return -1;
-    
-	GLuint* ptr = (GLuint *) glSelectionBuffer;
-    ptr += (hits - 1) * 4 + 3;
-	return *ptr;
+	return type == PickIndex::kKey ? GlobalSettings::frameSize * 1.5 / 2 : GlobalSettings::frameSize / 2;
+}
+
+static const PickIndex::Item* pathHit(const short mx, const short my, const PickIndex::Type type, MotionPath* motionPathPtr, M3dView &view, MotionPathManager &mpManager, const bool last)
+{
+	const PickIndex *pickIndex = mpManager.getPickIndex(view);
+	int path = mpManager.getMotionPathIndex(motionPathPtr);
+	if (!pickIndex || path == -1)
+		return NULL;
+
+	std::vector<const PickIndex::Item*> hits;
+	pickIndex->query(type, path, mx, my, pickRadius(type), hits);
+	if (hits.empty())
+		return NULL;
+	return last ? hits.back() : hits.front();
 }
 
 int contextUtils::processCurveHits(const short mx, const short my, const MMatrix &cameraMatrix, M3dView &view, CameraCache *cachePtr, MotionPathManager &mpManager)
 {
-	for (unsigned int i = 0; i < mpManager.getMotionPathsCount(); ++i)
+	const PickIndex *pickIndex = mpManager.getPickIndex(view);
+	if (!pickIndex)
+		return -1;
+
+	//the first path with a key, tangent or frame under the cursor, as when the paths were checked one by one
+	int hitPath = -1;
+	PickIndex::Type types[3] = {PickIndex::kKey, PickIndex::kTangent, PickIndex::kFrame};
+	for (unsigned int t = 0; t < 3; ++t)
 	{
-		MotionPath* mpPtr = mpManager.getMotionPathPtr(i);
-		if (!mpPtr)
-			continue;
-
-		std::vector<std::pair<int, MVector>> vec;
-		
-		MIntArray keys;
-		contextUtils::processKeyFrameHits(mx, my, mpPtr, view, cameraMatrix, cachePtr, keys);
-		if (keys.length() > 0)
-			return i;
-
-		int selectedKeyId, selectedTangent;
-		contextUtils::processTangentHits(mx, my, mpPtr, view, cameraMatrix, cachePtr, selectedKeyId, selectedTangent);
-		if (selectedTangent != -1)
-			return i;
-
-		double time;
-		if (contextUtils::processFramesHits(mx, my, mpPtr, view, cameraMatrix, cachePtr, time))
-			return i;
+		std::vector<const PickIndex::Item*> hits;
+		pickIndex->query(types[t], -1, mx, my, pickRadius(types[t]), hits);
+		if (!hits.empty() && (hitPath == -1 || hits.front()->path < hitPath))
+			hitPath = hits.front()->path;
 	}
-	return -1;
+	return hitPath;
 }
 
 void contextUtils::processKeyFrameHits(const short mx, const short my, MotionPath* motionPathPtr, M3dView &view, const MMatrix &cameraMatrix, CameraCache *cachePtr, MIntArray &selectedKeys)
 {
-	KeyframeMap *km = motionPathPtr->keyFramesCachePtr();
-	int key = -1;
-
-	double kfs = GlobalSettings::frameSize * 1.5 / 2;
-	kfs = kfs * kfs;
-	for (KeyframeMapIterator it = km->begin(); it != km->end(); ++it)
-	{
-		Keyframe &k = it->second;
-		short x, y;
-		view.worldToView(k.worldPosition, x, y);
-
-		double distance = (mx - x) * (mx - x) + (my - y) * (my - y);
-		if (distance < kfs)
-			key = it->second.id;
-	}
-
-	if (key != -1)
-		selectedKeys.append(key);
+	//the last key within the radius wins
+	const PickIndex::Item *hit = pathHit(mx, my, PickIndex::kKey, motionPathPtr, view, mpManager, true);
+	if (hit)
+		selectedKeys.append(hit->id);
 }
 
 void contextUtils::processTangentHits(const short mx, const short my, MotionPath* motionPathPtr, M3dView &view, const MMatrix &cameraMatrix, CameraCache *cachePtr, int &selectedKeyId, int &selectedTangent)
 {
-	KeyframeMap *km = motionPathPtr->keyFramesCachePtr();
-
-	double tfs = GlobalSettings::frameSize / 2;
-	tfs = tfs * tfs;
-
 	selectedTangent = -1;
+	const PickIndex::Item *hit = pathHit(mx, my, PickIndex::kTangent, motionPathPtr, view, mpManager, false);
+	if (!hit)
+		return;
 
-	for (KeyframeMapIterator it = km->begin(); it != km->end(); ++it)
-	{
-		Keyframe &k = it->second;
-		short x, y;
-		view.worldToView(k.inTangentWorldFromCurve, x, y);
-
-		double distance = (mx - x) * (mx - x) + (my - y) * (my - y);
-		if  (distance < tfs)
-		{
-			selectedKeyId = k.id;
-			selectedTangent = (int)Keyframe::kInTangent;
-			return;
-		}
-
-		view.worldToView(k.outTangentWorldFromCurve, x, y);
-		distance = (mx - x) * (mx - x) + (my - y) * (my - y);
-		if (distance < tfs)
-		{
-			selectedKeyId = k.id;
-			selectedTangent = (int)Keyframe::kOutTangent;
-			return;
-		}
-	}
+	selectedKeyId = hit->id;
+	selectedTangent = hit->tangent;
 }
 
 bool contextUtils::processFramesHits(const short mx, const short my, MotionPath* motionPathPtr, M3dView &view, const MMatrix &cameraMatrix, CameraCache *cachePtr, double &time)
 {
-	double fs = GlobalSettings::frameSize / 2;
-	fs = fs * fs;
-
-	std::vector<std::pair<int, MVector>> vec;
-	motionPathPtr->getFramePositions(vec);
-	for (unsigned int i = 0; i < vec.size(); ++i)
-	{
-		MVector& pos = vec[i].second;
-
-		short x, y;
-		view.worldToView(MPoint(pos.x, pos.y, pos.z), x, y);
-
-		double distance = (mx - x) * (mx - x) + (my - y) * (my - y);
-		if (distance < fs)
-		{
-			time = vec[i].first;
-			return true;
-		}
-	}
+	const PickIndex::Item *hit = pathHit(mx, my, PickIndex::kFrame, motionPathPtr, view, mpManager, false);
+	if (!hit)
+		return false;
 
-	return false;
-}
-
-void contextUtils::processTangentHits(MotionPath* motionPathPtr, M3dView &view, CameraCache *cachePtr, int &selectedKeyId, int &selectedTangent)
-{
-    GLuint glSelectionBuffer[256];
-    GLint hits;
-    
-    view.beginSelect(glSelectionBuffer, 256);
-    view.initNames();
-    motionPathPtr->drawTangentsForSelection(view, cachePtr);
-    
-    hits = view.endSelect();
-    
-    if (hits == 0)
-    {
-        selectedTangent = -1;
-        return;
-    }
-    
-	GLuint* ptr = (GLuint *) glSelectionBuffer;
-    ptr += (hits - 1) * 5 + 3;
-    selectedKeyId = *ptr;
-    ++ptr;
-    selectedTangent = *ptr;
-}
-
-void contextUtils::processKeyFrameHits(MotionPath* motionPathPtr, M3dView &view, CameraCache *cachePtr, MIntArray &selectedKeys)
-{
-    GLuint glSelectionBuffer[256];
-    GLint hits;
-    
-    view.beginSelect(glSelectionBuffer, 256);
-    view.initNames();
-    motionPathPtr->drawKeysForSelection(view, cachePtr);
-    hits = view.endSelect();
-    
-    if (hits == 0)
-        return;
-    
-    GLuint* ptr = (GLuint *) glSelectionBuffer;
-    ptr += (hits - 1) * 4 + 1;
-    GLuint minZ = *ptr;
-    ptr += 2;
-    selectedKeys.append(*ptr);
-    
-    for (int i = 0; i < hits - 1; ++i)
-    {
-        if (minZ == glSelectionBuffer[i * 4 + 1])
-            selectedKeys.append(glSelectionBuffer[i * 4 + 3]);
-    }
-}
-
-bool contextUtils::processFramesHits(MotionPath* motionPathPtr, M3dView &view, CameraCache *cachePtr, double &time)
-{
-    GLuint glSelectionBuffer[256];
-    GLint hits;
-    
-    view.beginSelect(glSelectionBuffer, 256);
-    view.initNames();
-    motionPathPtr->drawFramesForSelection(view, cachePtr);
-    
-    hits = view.endSelect();
-    
-    if (hits == 0)
-        return false;
-    
-    GLuint* ptr = (GLuint *) glSelectionBuffer;
-    ptr += (hits - 1) * 4 + 3;
-    time = *ptr;
+	time = hit->id;
 	return true;
 }
 
@@ -0,0 +1,71 @@
+//
+//  DrawGovernor.cpp
+//  MotionPath
+//
+//
+
+#include "DrawGovernor.h"
+#include "GlobalSettings.h"
+
+//draws the average is smoothed over, and how long a panel must stay under half the budget to step back up
+static const double kSmoothing = 0.3;
+static const int kMinSamples = 3;
+static const int kCalmDrawsToRecover = 30;
+
+DrawGovernor::Level DrawGovernor::getPanelLevel(const void *panel) const
+{
+    if (GlobalSettings::drawTimeBudget <= 0)
+        return kFull;
+
+    std::map<const void*, PanelState>::const_iterator it = panels.find(panel);
+    return it != panels.end() ? it->second.level : kFull;
+}
+
+void DrawGovernor::reportPanelTime(const void *panel, const double milliseconds)
+{
+    PanelState &state = panels[panel];
+
+    if (GlobalSettings::drawTimeBudget <= 0)
+    {
+        state = PanelState();
+        return;
+    }
+
+    state.averageTime = state.samples == 0 ? milliseconds : state.averageTime * (1.0 - kSmoothing) + milliseconds * kSmoothing;
+    ++state.samples;
+
+    if (state.averageTime > GlobalSettings::drawTimeBudget)
+    {
+        state.calmDraws = 0;
+
+        //a few draws at the new level before judging it again
+        if (state.samples >= kMinSamples && state.level < kNumLevels - 1)
+        {
+            state.level = (Level) (state.level + 1);
+            state.samples = 0;
+        }
+    }
+    else if (state.averageTime < GlobalSettings::drawTimeBudget * 0.5)
+    {
+        if (++state.calmDraws >= kCalmDrawsToRecover && state.level > kFull)
+        {
+            state.level = (Level) (state.level - 1);
+            state.calmDraws = 0;
+            state.samples = 0;
+        }
+    }
+    else
+        state.calmDraws = 0;
+}
+
+DrawGovernor::Level DrawGovernor::getLevel() const
+{
+    Level level = kFull;
+    if (GlobalSettings::drawTimeBudget <= 0)
+        return level;
+
+    for (std::map<const void*, PanelState>::const_iterator it = panels.begin(); it != panels.end(); ++it)
+        if (it->second.level > level)
+            level = it->second.level;
+    return level;
+}
@@ -86,7 +86,45 @@ void drawUtils::drawPointWithColor(const MVector &point, float size, const MColo
     drawUtils::drawPoint(point, size);
 }
 
-void drawUtils::drawKeyFrames(std::vector<Keyframe *> keys, const float size, const double colorMultiplier,const int portWidth, const int portHeight, const bool showRotationKeyframes)
+void drawUtils::drawPathGeometry(const PathGeometry &geometry, const PathGeometry::Item item, const GLenum mode, float size)
+{
+    const std::vector<float> &positions = geometry.positions[item];
+    if (positions.empty())
+        return;
+    
+    glEnable(GL_BLEND);
+    glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+    float prevSize;
+    if (mode == GL_POINTS)
+    {
+        glGetFloatv(GL_POINT_SIZE, &prevSize);
+        glPointSize(size);
+        glEnable(GL_POINT_SMOOTH);
+    }
+    else
+    {
+        glGetFloatv(GL_LINE_WIDTH, &prevSize);
+        glLineWidth(size);
+    }
+    
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, &positions[0]);
+    glColorPointer(4, GL_FLOAT, 0, &geometry.colors[item][0]);
+    
+    glDrawArrays(mode, 0, static_cast<GLsizei>(positions.size() / 3));
+    
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    
+    if (mode == GL_POINTS)
+        glPointSize(prevSize);
+    else
+        glLineWidth(prevSize);
+}
+
+void drawUtils::drawKeyFrames(const std::vector<Keyframe *> &keys, const float size, const double colorMultiplier,const int portWidth, const int portHeight, const bool showRotationKeyframes)
 {
     glMatrixMode(GL_MODELVIEW); //combinazione matrici model e inversa camera
     glPushMatrix();
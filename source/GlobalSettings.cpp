@@ -23,7 +23,15 @@ bool GlobalSettings::showRotationKeyFrames = true;
 bool GlobalSettings::showPath = true;
 double GlobalSettings::drawTimeInterval = 0.1;
 int GlobalSettings::drawFrameInterval = 5;
+int GlobalSettings::cacheFillBudget = 8000;
+int GlobalSettings::prefetchFrames = 100;
+int GlobalSettings::samplingThreads = 0;
+bool GlobalSettings::persistentGeometry = false;
+double GlobalSettings::simplifyTolerance = 1.0;
+int GlobalSettings::labelBudget = 200;
+double GlobalSettings::drawTimeBudget = 30.0;
 MMatrix GlobalSettings::cameraMatrix;
+ScreenProjector GlobalSettings::screenProjector;
 int GlobalSettings::portWidth = 0;
 int GlobalSettings::portHeight = 0;
 bool GlobalSettings::lockedMode = false;
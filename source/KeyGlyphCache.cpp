@@ -0,0 +1,196 @@
+//
+//  KeyGlyphCache.cpp
+//  MotionPath
+//
+//
+
+#include "KeyGlyphCache.h"
+
+#include <cmath>
+
+static const unsigned int kDiskSegments = 16;
+static const double kBlackBackgroundFactor = 1.2;
+static const double kTwoPi = 6.283185307179586;
+
+static unsigned char axisMask(const std::vector<Keyframe::Axis> &axis)
+{
+    unsigned char mask = 0;
+    for (unsigned int i = 0; i < axis.size(); ++i)
+        mask |= 1 << axis[i];
+    return mask;
+}
+
+static void maskAxis(const unsigned char mask, std::vector<Keyframe::Axis> &axis)
+{
+    axis.clear();
+    for (int i = Keyframe::kAxisX; i <= Keyframe::kAxisZ; ++i)
+        if (mask & (1 << i))
+            axis.push_back((Keyframe::Axis) i);
+}
+
+bool KeyGlyphCache::isCurrent(const std::vector<Keyframe*> &keys, const float size, const double colorMultiplier, const bool showRotation) const
+{
+    if (keys.size() != glyphs.size() || size != this->size || colorMultiplier != this->colorMultiplier || showRotation != this->showRotation)
+        return false;
+
+    for (unsigned int i = 0; i < keys.size(); ++i)
+    {
+        std::vector<Keyframe::Axis> tAxis, rAxis;
+        keys[i]->getKeyTranslateAxis(tAxis);
+        if (showRotation)
+            keys[i]->getKeyRotateAxis(rAxis);
+
+        if (glyphs[i].translateMask != axisMask(tAxis) || glyphs[i].rotateMask != axisMask(rAxis) || glyphs[i].selected != keys[i]->selectedFromTool)
+            return false;
+    }
+
+    return true;
+}
+
+void KeyGlyphCache::update(const std::vector<Keyframe*> &keys, const float size, const double colorMultiplier, const bool showRotation)
+{
+    if (isCurrent(keys, size, colorMultiplier, showRotation))
+        return;
+
+    this->size = size;
+    this->colorMultiplier = colorMultiplier;
+    this->showRotation = showRotation;
+
+    triangleVertices.clear();
+    triangleColors.clear();
+    lineVertices.clear();
+    lineColors.clear();
+
+    glyphs.resize(keys.size());
+    for (unsigned int i = 0; i < keys.size(); ++i)
+    {
+        std::vector<Keyframe::Axis> tAxis, rAxis;
+        keys[i]->getKeyTranslateAxis(tAxis);
+        if (showRotation)
+            keys[i]->getKeyRotateAxis(rAxis);
+
+        glyphs[i].translateMask = axisMask(tAxis);
+        glyphs[i].rotateMask = axisMask(rAxis);
+        glyphs[i].selected = keys[i]->selectedFromTool;
+        buildGlyph(glyphs[i]);
+    }
+}
+
+void KeyGlyphCache::addDisk(const double radius, const MColor &color)
+{
+    double step = kTwoPi / kDiskSegments;
+    for (unsigned int i = 0; i < kDiskSegments; ++i)
+    {
+        triangleVertices.append(MPoint(0, 0));
+        triangleVertices.append(MPoint(radius * std::cos(step * i), radius * std::sin(step * i)));
+        triangleVertices.append(MPoint(radius * std::cos(step * (i + 1)), radius * std::sin(step * (i + 1))));
+
+        for (unsigned int j = 0; j < 3; ++j)
+            triangleColors.append(color);
+    }
+}
+
+void KeyGlyphCache::buildGlyph(Glyph &glyph)
+{
+    glyph.firstTriangleVertex = triangleVertices.length();
+    glyph.firstLineVertex = lineVertices.length();
+
+    std::vector<Keyframe::Axis> tAxis, rAxis;
+    maskAxis(glyph.translateMask, tAxis);
+    maskAxis(glyph.rotateMask, rAxis);
+
+    //keys with no translation keyed are not drawn at all
+    if (tAxis.size() > 0)
+    {
+        addDisk(size * kBlackBackgroundFactor / 2, MColor(0.0, 0.0, 0.0));
+
+        if (glyph.selected)
+            addDisk(size / 2, MColor(1.0, 1.0, 1.0));
+        else
+        {
+            //nested disks, one for each axis keyed
+            double stepSize = size / 2 / tAxis.size();
+            for (unsigned int i = 0; i < tAxis.size(); ++i)
+            {
+                MColor color(0.0, 0.0, 0.0);
+                Keyframe::getColorForAxis(tAxis[i], color);
+                addDisk(stepSize * (tAxis.size() - i), color * colorMultiplier);
+            }
+        }
+
+        double unit = size * kBlackBackgroundFactor / 2;
+        double x1s[3] = { -unit * 0.8, unit * 1.5,  unit * -1.5 };
+        double y1s[3] = { unit * 1.2,  unit * 0.1,  unit * 0.1 };
+        double x2s[3] = { unit * 0.8,  unit * 0.7,  unit * -0.7 };
+        double y2s[3] = { unit * 1.2,  unit * -1.2, unit * -1.2 };
+
+        for (unsigned int i = 0; i < rAxis.size(); ++i)
+        {
+            MColor color;
+            Keyframe::getColorForAxis(rAxis[i], color);
+            color *= colorMultiplier;
+
+            lineVertices.append(MPoint(x1s[i], y1s[i]));
+            lineVertices.append(MPoint(x2s[i], y2s[i]));
+            lineColors.append(color);
+            lineColors.append(color);
+        }
+    }
+
+    glyph.triangleVertexCount = triangleVertices.length() - glyph.firstTriangleVertex;
+    glyph.lineVertexCount = lineVertices.length() - glyph.firstLineVertex;
+}
+
+void KeyGlyphCache::draw(const std::vector<MPoint> &centers, const std::vector<unsigned char> &visible, MHWRender::MUIDrawManager* drawManager) const
+{
+    unsigned int numGlyphs = glyphs.size() < centers.size() ? static_cast<unsigned int>(glyphs.size()) : static_cast<unsigned int>(centers.size());
+
+    unsigned int numTriangleVertices = 0, numLineVertices = 0;
+    for (unsigned int i = 0; i < numGlyphs; ++i)
+    {
+        if (!visible[i])
+            continue;
+        numTriangleVertices += glyphs[i].triangleVertexCount;
+        numLineVertices += glyphs[i].lineVertexCount;
+    }
+
+    MPointArray triangles, lines;
+    MColorArray triangleVertexColors, lineVertexColors;
+    triangles.setLength(numTriangleVertices);
+    triangleVertexColors.setLength(numTriangleVertices);
+    lines.setLength(numLineVertices);
+    lineVertexColors.setLength(numLineVertices);
+
+    unsigned int triangleIndex = 0, lineIndex = 0;
+    for (unsigned int i = 0; i < numGlyphs; ++i)
+    {
+        if (!visible[i])
+            continue;
+
+        const Glyph &glyph = glyphs[i];
+        MVector offset(centers[i].x, centers[i].y, 0);
+        for (unsigned int j = 0; j < glyph.triangleVertexCount; ++j, ++triangleIndex)
+        {
+            triangles[triangleIndex] = triangleVertices[glyph.firstTriangleVertex + j] + offset;
+            triangleVertexColors[triangleIndex] = triangleColors[glyph.firstTriangleVertex + j];
+        }
+
+        for (unsigned int j = 0; j < glyph.lineVertexCount; ++j, ++lineIndex)
+        {
+            lines[lineIndex] = lineVertices[glyph.firstLineVertex + j] + offset;
+            lineVertexColors[lineIndex] = lineColors[glyph.firstLineVertex + j];
+        }
+    }
+
+    if (numTriangleVertices > 0)
+        drawManager->mesh2d(MHWRender::MUIDrawManager::kTriangles, triangles, &triangleVertexColors);
+
+    if (numLineVertices > 0)
+    {
+        double lineWidth = size / 5;
+        if (lineWidth < 1) lineWidth = 1;
+
+        drawManager->setLineWidth(lineWidth);
+        drawManager->mesh2d(MHWRender::MUIDrawManager::kLines, lines, &lineVertexColors);
+    }
+}
@@ -0,0 +1,118 @@
+//
+//  LabelPlacer.cpp
+//  MotionPath
+//
+//
+
+#include "LabelPlacer.h"
+#include "GlobalSettings.h"
+#include "DrawUtils.h"
+#include "Vp2DrawUtils.h"
+
+#include <cmath>
+
+//rough size of the default font, a label covers the cells under its box
+static const double kCharWidth = 7.0;
+static const double kLineHeight = 12.0;
+static const int kCellSize = 12;
+
+void LabelPlacer::begin(const int portWidth, const int portHeight)
+{
+    width = portWidth;
+    height = portHeight;
+    columns = width > 0 ? (width + kCellSize - 1) / kCellSize : 0;
+    rows = height > 0 ? (height + kCellSize - 1) / kCellSize : 0;
+    occupied.assign(columns * rows, 0);
+
+    for (int i = 0; i < kNumPriorities; ++i)
+        labels[i].clear();
+}
+
+void LabelPlacer::addLabel(const double frame, const MVector &worldPosition, const double sizeOffset, const MColor &color, const Priority priority)
+{
+    Label label;
+    label.frame = frame;
+    label.worldPosition = worldPosition;
+    label.sizeOffset = sizeOffset;
+    label.color = color;
+    labels[priority].push_back(label);
+}
+
+LabelPlacer::Priority LabelPlacer::priorityForFrame(const double frame, const bool hasKey)
+{
+    if (hasKey)
+        return kKeyFrame;
+
+    //round frame numbers are the ones worth keeping when the labels are crowded
+    int frameNumber = static_cast<int>(std::floor(frame + 0.5));
+    if (frameNumber % 10 == 0)
+        return kTenthFrame;
+    if (frameNumber % 5 == 0)
+        return kFifthFrame;
+    return kFrame;
+}
+
+bool LabelPlacer::place(const double x, const double y, const double frame)
+{
+    MString text;
+    text = frame;
+
+    double halfWidth = text.length() * kCharWidth * 0.5;
+    double halfHeight = kLineHeight * 0.5;
+    if (x + halfWidth < 0 || x - halfWidth >= width || y + halfHeight < 0 || y - halfHeight >= height)
+        return false;
+
+    int minColumn = static_cast<int>(std::floor((x - halfWidth) / kCellSize));
+    int maxColumn = static_cast<int>(std::floor((x + halfWidth) / kCellSize));
+    int minRow = static_cast<int>(std::floor((y - halfHeight) / kCellSize));
+    int maxRow = static_cast<int>(std::floor((y + halfHeight) / kCellSize));
+    if (minColumn < 0) minColumn = 0;
+    if (minRow < 0) minRow = 0;
+    if (maxColumn >= columns) maxColumn = columns - 1;
+    if (maxRow >= rows) maxRow = rows - 1;
+
+    for (int r = minRow; r <= maxRow; ++r)
+        for (int c = minColumn; c <= maxColumn; ++c)
+            if (occupied[r * columns + c])
+                return false;
+
+    for (int r = minRow; r <= maxRow; ++r)
+        for (int c = minColumn; c <= maxColumn; ++c)
+            occupied[r * columns + c] = 1;
+
+    return true;
+}
+
+void LabelPlacer::draw(const ScreenProjector &projector, M3dView &view, const MMatrix &refMatrix, MHWRender::MUIDrawManager* drawManager)
+{
+    int budget = GlobalSettings::labelBudget;
+    for (int p = 0; p < kNumPriorities && budget > 0; ++p)
+    {
+        if (labels[p].empty())
+            continue;
+
+        std::vector<MVector> positions(labels[p].size());
+        for (unsigned int i = 0; i < labels[p].size(); ++i)
+            positions[i] = labels[p][i].worldPosition;
+
+        std::vector<float> screen;
+        std::vector<unsigned char> visible;
+        projector.project(positions, screen, visible);
+
+        for (unsigned int i = 0; i < labels[p].size() && budget > 0; ++i)
+        {
+            const Label &label = labels[p][i];
+            double x = screen[i * 2];
+            double y = screen[i * 2 + 1] + GlobalSettings::frameSize * label.sizeOffset;
+            if (!visible[i] || !place(x, y, label.frame))
+                continue;
+
+            if (drawManager)
+                VP2DrawUtils::drawFrameLabel(label.frame, screen[i * 2], screen[i * 2 + 1], label.sizeOffset, label.color, drawManager);
+            else
+                drawUtils::drawFrameLabel(label.frame, label.worldPosition, view, label.sizeOffset, label.color, refMatrix);
+
+            --budget;
+        }
+    }
+}
@@ -13,14 +13,18 @@
 #include "MotionPathManager.h"
 #include "GlobalSettings.h"
 #include "MotionPath.h"
-#include "animCurveUtils.h"
 #include "Vp2DrawUtils.h"
 
 #include <maya/MPlugArray.h>
 #include <maya/MAnimUtil.h>
 #include <maya/MFnTransform.h>
 #include <maya/MEulerRotation.h>
+#include <maya/MFnNumericData.h>
 #include <maya/MPxTransformationMatrix.h>
+#include <maya/MTimeArray.h>
+#include <maya/MDoubleArray.h>
+
+#include <algorithm>
 
 
 extern MotionPathManager mpManager;
@@ -38,13 +42,9 @@ MotionPath::MotionPath(const MObject &object)
     ryPlug = depNodFn.findPlug("rotateY");
     rzPlug = depNodFn.findPlug("rotateZ");
     
-    rpxPlug = depNodFn.findPlug("rotatePivotX");
-    rpyPlug = depNodFn.findPlug("rotatePivotY");
-    rpzPlug = depNodFn.findPlug("rotatePivotZ");
-    
-    rptxPlug = depNodFn.findPlug("rotatePivotTranslateX");
-    rptyPlug = depNodFn.findPlug("rotatePivotTranslateY");
-    rptzPlug = depNodFn.findPlug("rotatePivotTranslateZ");
+    translatePlug = depNodFn.findPlug("translate");
+    rotatePivotPlug = depNodFn.findPlug("rotatePivot");
+    rotatePivotTranslatePlug = depNodFn.findPlug("rotatePivotTranslate");
 
     isDrawing = false;
     
@@ -58,6 +58,19 @@ MotionPath::MotionPath(const MObject &object)
     colorMultiplier = 1.0;
     
     isWeighted = false;
+    nativeTranslate = false;
+    translateSnapshotsNative = false;
+    translateSnapshotsValid = false;
+    translateSnapshotsVersion = 0;
+    nativePositionsStart = 0;
+    chainSnapshotDirty = true;
+    keyframesDirty = true;
+    previewSamplesDirty = false;
+    geometryVersion = 0;
+    keyframesStartTime = 0;
+    keyframesEndTime = 0;
+    keyframesShowRotation = false;
+    keyframesDrawing = false;
     
     constrained = isConstrained(object);
 	findParentMatrixPlug(object, constrained, pMatrixPlug);
@@ -99,83 +112,19 @@ void MotionPath::cacheParentMatrixRange()
     
     if(startFrame < GlobalSettings::startTime)	startFrame = GlobalSettings::startTime;
     if(endFrame > GlobalSettings::endTime) 	endFrame = GlobalSettings::endTime;
+    pMatrixCache.reserve(static_cast<int>(startFrame), static_cast<int>(endFrame));
     for (double i = startFrame; i <= endFrame; ++i)
         ensureParentAndPivotMatrixAtTime(i);
 }
 
 void MotionPath::cacheParentMatrixRangeForWorldCallback(MObject &transformNode)
 {
-    MFnDependencyNode depNodFn(transformNode);
-    MPlug txP = depNodFn.findPlug("translateX");
-    MPlug tyP = depNodFn.findPlug("translateY");
-    MPlug tzP = depNodFn.findPlug("translateZ");
-    
-    MPlug rxP = depNodFn.findPlug("rotateX");
-    MPlug ryP = depNodFn.findPlug("rotateY");
-    MPlug rzP = depNodFn.findPlug("rotateZ");
-    
-    MStatus txStatus, tyStatus, tzStatus, rxStatus, ryStatus, rzStatus, sxStatus, syStatus, szStatus;
-    MFnAnimCurve cTX(txP, &txStatus);
-    MFnAnimCurve cTY(tyP, &tyStatus);
-    MFnAnimCurve cTZ(tzP, &tzStatus);
-    MFnAnimCurve cRX(rxP, &rxStatus);
-    MFnAnimCurve cRY(ryP, &ryStatus);
-    MFnAnimCurve cRZ(rzP, &rzStatus);
-    
-    MTime currentTime = MAnimControl::currentTime();
-    
-    double newTXValue, newTYValue, newTZValue, newRXValue, newRYValue, newRZValue;
-    double oldTXValue, oldTYValue, oldTZValue, oldRXValue, oldRYValue, oldRZValue;
-    int newKeyTX, newKeyTY, newKeyTZ, newKeyRX, newKeyRY, newKeyRZ;
-    int oldKeyTX, oldKeyTY, oldKeyTZ, oldKeyRX, oldKeyRY, oldKeyRZ;
-    bool txUpdated, tyUpdated, tzUpdated, rxUpdated, ryUpdated, rzUpdated;
-    if (txStatus != MS::kNotFound)
-        txUpdated = animCurveUtils::updateCurve(txP, cTX, currentTime, oldTXValue, newTXValue, newKeyTX, oldKeyTX);
-    if (tyStatus != MS::kNotFound)
-        tyUpdated = animCurveUtils::updateCurve(tyP, cTY, currentTime, oldTYValue, newTYValue, newKeyTY, oldKeyTY);
-    if (tzStatus != MS::kNotFound)
-        tzUpdated = animCurveUtils::updateCurve(tzP, cTZ, currentTime, oldTZValue, newTZValue, newKeyTZ, oldKeyTZ);
-    if (rxStatus != MS::kNotFound)
-        rxUpdated = animCurveUtils::updateCurve(rxP, cRX, currentTime, oldRXValue, newRXValue, newKeyRX, oldKeyRX);
-    if (ryStatus != MS::kNotFound)
-        ryUpdated = animCurveUtils::updateCurve(ryP, cRY, currentTime, oldRYValue, newRYValue, newKeyRY, oldKeyRY);
-    if (rzStatus != MS::kNotFound)
-        rzUpdated = animCurveUtils::updateCurve(rzP, cRZ, currentTime, oldRZValue, newRZValue, newKeyRZ, oldKeyRZ);
+    //the ancestor being moved might not be keyed, its current values are overlaid on our snapshot of its curves.
+    //When going through the DG they only show up at the current frame
+    if (useNativeChain())
+        chainEvaluator.overlayLiveValues(transformNode, MAnimControl::currentTime());
     
     cacheParentMatrixRange();
-    
-    if (txUpdated && txStatus != MS::kNotFound)
-    {
-        animCurveUtils::restoreCurve(cTX, currentTime, oldTXValue, newKeyTX, oldKeyTX);
-        txP.setValue(newTXValue);
-    }
-    if (tyUpdated && tyStatus != MS::kNotFound)
-    {
-        animCurveUtils::restoreCurve(cTY, currentTime, oldTYValue, newKeyTY, oldKeyTY);
-        tyP.setValue(newTYValue);
-    }
-    if (tzUpdated && tzStatus != MS::kNotFound )
-    {
-        animCurveUtils::restoreCurve(cTZ, currentTime, oldTZValue, newKeyTZ, oldKeyTZ);
-        tzP.setValue(newTZValue);
-    }
-    
-    if (rxUpdated && rxStatus != MS::kNotFound)
-    {
-        animCurveUtils::restoreCurve(cRX, currentTime, oldRXValue, newKeyRX, oldKeyRX);
-        rxP.setValue(newRXValue);
-    }
-    if (ryUpdated && ryStatus != MS::kNotFound)
-    {
-        animCurveUtils::restoreCurve(cRY, currentTime, oldRYValue, newKeyRY, oldKeyRY);
-        ryP.setValue(newRYValue);
-    }
-    if (rzUpdated && rzStatus != MS::kNotFound )
-    {
-        animCurveUtils::restoreCurve(cRZ, currentTime, oldRZValue, newKeyRZ, oldKeyRZ);
-        rzP.setValue(newRZValue);
-    }
-    
 }
 
 bool MotionPath::getWorldSpaceCallbackCalled()
@@ -299,6 +248,37 @@ bool MotionPath::isConstrained(const MFnDagNode &dagNodeFn)
 void MotionPath::clearParentMatrixCache()
 {
     pMatrixCache.clear();
+    chainSnapshotDirty = true;
+    keyframesDirty = true;
+}
+
+void MotionPath::prefetchParentMatrixAtTime(const double time)
+{
+    if (time >= startTime && time <= endTime)
+        ensureParentAndPivotMatrixAtTime(time);
+}
+
+bool MotionPath::evictParentMatrixCache(const double keepStart, const double keepEnd)
+{
+    pMatrixCache.evictOutside(keepStart, keepEnd);
+    
+    //the cached range has to follow what is left, otherwise the display range gets clamped to frames we no longer have
+    //and the fill would never bring them back
+    bool shrunk = false;
+    if (startTimeCached < keepStart)
+    {
+        startTimeCached = keepStart;
+        shrunk = true;
+    }
+    if (endTimeCached > keepEnd)
+    {
+        endTimeCached = keepEnd;
+        shrunk = true;
+    }
+    
+    if (shrunk)
+        cacheDone = false;
+    return shrunk;
 }
 
 void MotionPath::findParentMatrixPlug(const MObject &transform, const bool constrained, MPlug &matrixPlug)
@@ -332,11 +312,18 @@ void MotionPath::setDisplayTimeRange(double start, double end)
 	if(displayEndTime > endTimeCached)
 		displayEndTime = endTimeCached;
 
+    pMatrixCache.reserve(static_cast<int>(displayStartTime), static_cast<int>(displayEndTime));
+
 }
 
 MMatrix MotionPath::getMatrixFromPlug(const MPlug &matrixPlug, const MTime &t)
 {
 	MDGContext context(t);
+	return getMatrixFromPlug(matrixPlug, context);
+}
+
+MMatrix MotionPath::getMatrixFromPlug(const MPlug &matrixPlug, MDGContext &context)
+{
 	MObject val;
 	matrixPlug.getValue(val, context);
 	return MFnMatrixData(val).matrix();
@@ -380,65 +367,230 @@ void MotionPath::drawKeyFrames(CameraCache *cachePtr, MMatrix &currentCameraMatr
     }
     
 	if (drawManager)
-		VP2DrawUtils::drawKeyFramePoints(keyframesCache, GlobalSettings::frameSize * 1.5, colorMultiplier, portWidth, portHeight, GlobalSettings::showRotationKeyFrames, currentCameraMatrix, drawManager, frameContext);
+		VP2DrawUtils::drawKeyFramePoints(keyframesCache, keyGlyphs, GlobalSettings::frameSize * 1.5, colorMultiplier, GlobalSettings::showRotationKeyFrames, GlobalSettings::screenProjector, drawManager);
 	else
 		drawUtils::drawKeyFramePoints(keyframesCache, GlobalSettings::frameSize * 1.5, colorMultiplier, portWidth, portHeight, GlobalSettings::showRotationKeyFrames);
 }
 
-void MotionPath::drawFrames(CameraCache* cachePtr, const MMatrix &currentCameraMatrix, M3dView &view, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
+MColor MotionPath::getPathColor()
 {
     MColor curveColor = isWeighted ? GlobalSettings::weightedPathColor : GlobalSettings::pathColor;
 
     if(this->selectedFromTool)  curveColor *= 1.3;
 
     curveColor *= colorMultiplier;
+    return curveColor;
+}
+
+MColor MotionPath::getTangentColor(const Keyframe *key)
+{
+    if (isWeighted)
+        return GlobalSettings::weightedPathTangentColor;
+    return key->tangentsLocked ? GlobalSettings::tangentColor : GlobalSettings::brokenTangentColor;
+}
+
+void MotionPath::drawFrames(CameraCache* cachePtr, const MMatrix &currentCameraMatrix, M3dView &view, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
+{
+    MColor curveColor = getPathColor();
     
-    ensureParentAndPivotMatrixAtTime(displayStartTime);
+    if (drawManager)
+    {
+        drawFramesMesh(cachePtr, currentCameraMatrix, curveColor, drawManager);
+        return;
+    }
     
-    MVector previousWorldPos = multPosByParentMatrix(getPos(displayStartTime), pMatrixCache[displayStartTime]);
-    if (GlobalSettings::motionPathDrawMode == GlobalSettings::kCameraSpace)
+    //legacy viewport: the vertices the viewport 2.0 buffers get, sent with one call per primitive type
+    fillGeometry(legacyGeometry, cachePtr, &GlobalSettings::screenProjector);
+    drawUtils::drawPathGeometry(legacyGeometry, PathGeometry::kPath, GL_LINES, GlobalSettings::pathSize);
+    drawUtils::drawPathGeometry(legacyGeometry, PathGeometry::kFrames, GL_POINTS, GlobalSettings::pathSize);
+}
+
+void MotionPath::addPickItems(PickIndex &pickIndex, const int pathIndex, CameraCache* cachePtr, const ScreenProjector &projector)
+{
+    std::vector<MVector> positions;
+    std::vector<PickIndex::Type> types;
+    std::vector<int> ids, tangents;
+    
+    //only what drawPath put on screen for this panel can be hit, hidden handles would steal the clicks
+    bool keysDrawn = GlobalSettings::showKeyFrames;
+    bool tangentsDrawn = keysDrawn && GlobalSettings::showTangents && mpManager.getDrawLevel() < DrawGovernor::kNoTangents;
+    
+    for (KeyframeMapIterator keyIt = keyframesCache.begin(); keysDrawn && keyIt != keyframesCache.end(); keyIt++)
     {
-        cachePtr->ensureMatricesAtTime(displayStartTime);
-        previousWorldPos = MPoint(previousWorldPos) * cachePtr->matrixCache[displayStartTime] * currentCameraMatrix;
+        positions.push_back(keyIt->second.worldPosition);
+        types.push_back(PickIndex::kKey);
+        ids.push_back(keyIt->second.id);
+        tangents.push_back(-1);
     }
     
-	for(double i = displayStartTime + 1.0; i <= displayEndTime; i += 1.0)
-	{
-        ensureParentAndPivotMatrixAtTime(i);
+    for (KeyframeMapIterator keyIt = keyframesCache.begin(); tangentsDrawn && keyIt != keyframesCache.end(); keyIt++)
+    {
+        const Keyframe &key = keyIt->second;
+        if (key.showInTangent)
+        {
+            positions.push_back(key.inTangentWorldFromCurve);
+            types.push_back(PickIndex::kTangent);
+            ids.push_back(key.id);
+            tangents.push_back(Keyframe::kInTangent);
+        }
         
-		MVector worldPos = multPosByParentMatrix(getPos(i), pMatrixCache[i]);
+        if (key.showOutTangent)
+        {
+            positions.push_back(key.outTangentWorldFromCurve);
+            types.push_back(PickIndex::kTangent);
+            ids.push_back(key.id);
+            tangents.push_back(Keyframe::kOutTangent);
+        }
+    }
+    
+    //samples are cached by now, so this never goes back to the DG
+    MPointArray points;
+    collectFramePoints(cachePtr, GlobalSettings::cameraMatrix, points);
+    for (unsigned int j = 0; j < points.length(); ++j)
+    {
+        positions.push_back(points[j]);
+        types.push_back(PickIndex::kFrame);
+        ids.push_back(static_cast<int>(displayStartTime) + j);
+        tangents.push_back(-1);
+    }
+    
+    std::vector<float> screen;
+    std::vector<unsigned char> visible;
+    projector.project(positions, screen, visible);
+    
+    for (unsigned int i = 0; i < positions.size(); ++i)
+        if (visible[i])
+            pickIndex.add(types[i], pathIndex, ids[i], tangents[i], screen[i * 2], screen[i * 2 + 1]);
+}
+
+void MotionPath::collectFramePoints(CameraCache* cachePtr, const MMatrix &currentCameraMatrix, MPointArray &points)
+{
+    points.clear();
+    for(double i = displayStartTime; i <= displayEndTime; i += 1.0)
+    {
+        MPoint worldPos = ensureSampleAtTime(i).worldPosition;
         if (GlobalSettings::motionPathDrawMode == GlobalSettings::kCameraSpace)
         {
             cachePtr->ensureMatricesAtTime(i);
-            worldPos = MPoint(worldPos) * cachePtr->matrixCache[i] * currentCameraMatrix;
+            worldPos = worldPos * cachePtr->matrixCache[i] * currentCameraMatrix;
         }
+        points.append(worldPos);
+    }
+}
+
+void MotionPath::collectForcedFrames(std::vector<unsigned int> &forced)
+{
+    //keyframes and the current frame stay exactly where they are
+    forced.clear();
+    for (KeyframeMapIterator it = keyframesCache.begin(); it != keyframesCache.end(); ++it)
+        if (it->first >= displayStartTime && it->first <= displayEndTime)
+            forced.push_back(static_cast<unsigned int>(it->first - displayStartTime + 0.5));
+    
+    double currentTime = MAnimControl::currentTime().as(MTime::uiUnit());
+    if (currentTime >= displayStartTime && currentTime <= displayEndTime)
+        forced.push_back(static_cast<unsigned int>(currentTime - displayStartTime + 0.5));
+}
+
+void MotionPath::keepEveryFifthFrame(const std::vector<unsigned int> &forced, std::vector<unsigned char> &keep)
+{
+    for (unsigned int j = 0; j < keep.size(); ++j)
+        if (int(displayStartTime + j) % 5 != 0)
+            keep[j] = 0;
+    for (unsigned int i = 0; i < forced.size(); ++i)
+        if (forced[i] < keep.size())
+            keep[forced[i]] = 1;
+}
+
+void MotionPath::thinFrames(std::vector<unsigned char> &keepLine, std::vector<unsigned char> &keepDots)
+{
+    //without a view there is nothing to simplify against, the levels fall back to plain decimation
+    DrawGovernor::Level level = mpManager.getDrawLevel();
+    if (level < DrawGovernor::kSparseFrames)
+        return;
+    
+    std::vector<unsigned int> forced;
+    collectForcedFrames(forced);
+    
+    keepEveryFifthFrame(forced, keepDots);
+    if (level >= DrawGovernor::kSimplifiedPath)
+        keepEveryFifthFrame(forced, keepLine);
+}
+
+void MotionPath::simplifyFrames(const MPointArray &points, const ScreenProjector &projector, std::vector<unsigned char> &keepLine, std::vector<unsigned char> &keepDots)
+{
+    std::vector<unsigned int> forced;
+    collectForcedFrames(forced);
+    
+    //an overloaded panel first thins out the dots and then simplifies the line a lot more
+    DrawGovernor::Level level = mpManager.getDrawLevel();
+    double tolerance = GlobalSettings::simplifyTolerance;
+    if (level >= DrawGovernor::kSimplifiedPath)
+        tolerance = tolerance > 1.0 ? tolerance * 4.0 : 4.0;
+    
+    simplifier.update(points);
+    simplifier.select(projector, tolerance, forced, keepLine, keepDots);
+    
+    if (level >= DrawGovernor::kSparseFrames)
+        keepEveryFifthFrame(forced, keepDots);
+}
+
+void MotionPath::drawFramesMesh(CameraCache* cachePtr, const MMatrix &currentCameraMatrix, const MColor &curveColor, MHWRender::MUIDrawManager* drawManager)
+{
+    MPointArray points;
+    collectFramePoints(cachePtr, currentCameraMatrix, points);
+    
+    std::vector<unsigned char> keepLine, keepDots;
+    simplifyFrames(points, GlobalSettings::screenProjector, keepLine, keepDots);
+    
+    //only the chunks of frames inside the frustum are sent, on a close up most of a long path is skipped here
+    segmentBounds.build(points);
+    std::vector<SegmentBounds::Range> ranges;
+    segmentBounds.visibleRanges(GlobalSettings::screenProjector, ranges);
+    
+    for (unsigned int r = 0; r < ranges.size(); ++r)
+    {
+        unsigned int first = ranges[r].first;
+        unsigned int last = ranges[r].second;
         
-        if (GlobalSettings::showPath)
+        //the ends of a range are kept so neighbouring ranges still join up
+        MPointArray linePoints, dotPoints;
+        for (unsigned int j = first; j <= last; ++j)
+        {
+            if (keepLine[j] || j == first || j == last)
+                linePoints.append(points[j]);
+            if (keepDots[j])
+                dotPoints.append(points[j]);
+        }
+        
+        if (GlobalSettings::showPath && last > first)
         {
-            double factor = 1;
             if (GlobalSettings::alternatingFrames)
-                factor = int(i) % 2 == 1 ? 1.4 : 0.6;
+            {
+                //every segment has its own color, so the vertices are doubled up rather than shared by a strip
+                MPointArray segments;
+                MColorArray colors;
+                segments.setLength(2 * (last - first));
+                colors.setLength(2 * (last - first));
+                for (unsigned int j = first + 1; j <= last; ++j)
+                {
+                    double frame = displayStartTime + j;
+                    MColor segmentColor = curveColor * (int(frame) % 2 == 1 ? 1.4 : 0.6);
+                    
+                    unsigned int k = j - first;
+                    segments[2 * k - 2] = points[j - 1];
+                    segments[2 * k - 1] = points[j];
+                    colors[2 * k - 2] = segmentColor;
+                    colors[2 * k - 1] = segmentColor;
+                }
                 
-			if (drawManager)
-				VP2DrawUtils::drawLineWithColor(previousWorldPos, worldPos, GlobalSettings::pathSize, curveColor * factor, currentCameraMatrix, drawManager, frameContext);
-			else
-				drawUtils::drawLineWithColor(previousWorldPos, worldPos, GlobalSettings::pathSize, curveColor * factor);
+                VP2DrawUtils::drawLineMesh(segments, &colors, false, GlobalSettings::pathSize, curveColor, drawManager);
+            }
+            else
+                VP2DrawUtils::drawLineMesh(linePoints, NULL, true, GlobalSettings::pathSize, curveColor, drawManager);
         }
-
-		if (drawManager)
-			VP2DrawUtils::drawPointWithColor(previousWorldPos, GlobalSettings::pathSize * 2, curveColor, currentCameraMatrix, drawManager, frameContext);
-		else
-			drawUtils::drawPointWithColor(previousWorldPos, GlobalSettings::pathSize, curveColor);
-        previousWorldPos = worldPos;
         
-		if (i == displayEndTime)
-		{
-			if (drawManager)
-				VP2DrawUtils::drawPointWithColor(worldPos, GlobalSettings::pathSize * 2, curveColor, currentCameraMatrix, drawManager, frameContext);
-			else
-				drawUtils::drawPointWithColor(worldPos, GlobalSettings::pathSize, curveColor);
-		}
-	}
+        VP2DrawUtils::drawPointMesh(dotPoints, GlobalSettings::pathSize * 2, curveColor, drawManager);
+    }
 }
 
 void MotionPath::expandKeyFramesCache(const MFnAnimCurve &curve, const Keyframe::Axis &axisName, bool isTranslate)
@@ -484,17 +636,17 @@ void MotionPath::expandKeyFramesCache(const MFnAnimCurve &curve, const Keyframe:
 }
 
 MVector MotionPath::getPos(double time)
+{
+	MTime evalTime(time, MTime::uiUnit());
+	MDGContext context(evalTime);
+	return getPos(context);
+}
+
+MVector MotionPath::getPos(MDGContext &context)
 {
 	MVector pos(0.0, 0.0, 0.0);
 	if(this->constrained == false)
-	{
-		MTime evalTime(time, MTime::uiUnit());
-		MDGContext context(evalTime);
-        
-		pos.x = txPlug.asDouble(context);
-		pos.y = tyPlug.asDouble(context);
-		pos.z = tzPlug.asDouble(context);
-	}
+		pos = getVectorFromPlug(context, translatePlug);
     
 	return pos;
 }
@@ -565,51 +717,189 @@ void MotionPath::setShowInOutTangents(const MFnAnimCurve &curveTX, const MFnAnim
     }
 }
 
-MVector MotionPath::getVectorFromPlugs(const MTime &evalTime, const MPlug &x, const MPlug &y, const MPlug &z)
+MVector MotionPath::getVectorFromPlug(MDGContext &context, const MPlug &plug)
 {
-    MDGContext context(evalTime);
+    // reading the compound plug evaluates the three children in one go
+    MObject data;
+    plug.getValue(data, context);
     
-    MVector pos;
-    pos.x = x.asDouble(context);
-    pos.y = y.asDouble(context);
-    pos.z = z.asDouble(context);
-    return pos;
+    MVector vec;
+    MFnNumericData(data).getData(vec.x, vec.y, vec.z);
+    return vec;
 }
 
 MMatrix MotionPath::getPMatrixAtTime(const MTime &evalTime)
 {
-    MMatrix m = getMatrixFromPlug(pMatrixPlug, evalTime);
+    MDGContext context(evalTime);
+    return getPMatrixAtTime(context);
+}
+
+MMatrix MotionPath::applyPivots(const MMatrix &matrix, const MVector &rotatePivot, const MVector &rotatePivotTranslate)
+{
+    MMatrix m = matrix;
+    
+    MMatrix pivotMtx;
+    pivotMtx[3][0] = rotatePivot.x;
+    pivotMtx[3][1] = rotatePivot.y;
+    pivotMtx[3][2] = rotatePivot.z;
+    m = pivotMtx * m;
+    
+    pivotMtx[3][0] = rotatePivotTranslate.x;
+    pivotMtx[3][1] = rotatePivotTranslate.y;
+    pivotMtx[3][2] = rotatePivotTranslate.z;
+    m = pivotMtx * m;
+    
+    return m;
+}
+
+MMatrix MotionPath::getPMatrixAtTime(MDGContext &context)
+{
+    MMatrix m = getMatrixFromPlug(pMatrixPlug, context);
 
     if (GlobalSettings::usePivots)
+        m = applyPivots(m, getVectorFromPlug(context, rotatePivotPlug), getVectorFromPlug(context, rotatePivotTranslatePlug));
+    
+    return m;
+}
+
+bool MotionPath::useNativeChain()
+{
+    if (chainSnapshotDirty)
     {
-        MVector piv = getVectorFromPlugs(evalTime, rpxPlug, rpyPlug, rpzPlug);
-		MMatrix pivotMtx;
-        pivotMtx[3][0] = piv.x;
-        pivotMtx[3][1] = piv.y;
-        pivotMtx[3][2] = piv.z;
-		m = pivotMtx * m;
+        chainSnapshotDirty = false;
+        chainEvaluator.clear();
         
-        piv = getVectorFromPlugs(evalTime, rptxPlug, rptyPlug, rptzPlug);
-        pivotMtx[3][0] = piv.x;
-        pivotMtx[3][1] = piv.y;
-        pivotMtx[3][2] = piv.z;
-        m = pivotMtx * m;
+        //constrained paths read the world matrix of the node itself, there is no chain to compose
+        if (!constrained)
+        {
+            MDagPath dp;
+            MDagPath::getAPathTo(thisObject, dp);
+            if (chainEvaluator.snapshot(dp))
+            {
+                //the current frame might hold values that were not keyed yet
+                double currentFrame = MAnimControl::currentTime().as(MTime::uiUnit());
+                double frames[3] = {startTime, std::floor((startTime + endTime) * 0.5), endTime};
+                std::vector<double> times;
+                for (int i = 0; i < 3; ++i)
+                {
+                    if (frames[i] != currentFrame)
+                        times.push_back(MTime(frames[i], MTime::uiUnit()).as(MTime::kSeconds));
+                }
+                
+                if (!chainEvaluator.validate(pMatrixPlug, times))
+                    chainEvaluator.clear();
+            }
+        }
     }
     
+    return chainEvaluator.isValid();
+}
+
+MMatrix MotionPath::getNativePMatrixAtTime(const double time) const
+{
+    return getNativePMatrixAtSeconds(MTime(time, MTime::uiUnit()).as(MTime::kSeconds));
+}
+
+MMatrix MotionPath::getNativePMatrixAtSeconds(const double seconds) const
+{
+    MMatrix m = chainEvaluator.parentMatrix(seconds);
+    
+    if (GlobalSettings::usePivots)
+        m = applyPivots(m, chainEvaluator.rotatePivot(seconds), chainEvaluator.rotatePivotTranslate(seconds));
+    
     return m;
 }
 
-void MotionPath::ensureParentAndPivotMatrixAtTime(const double time)
+const MMatrix &MotionPath::ensureParentAndPivotMatrixAtTime(const double time)
+{
+    const MMatrix *cached = pMatrixCache.find(time);
+    if (cached)
+        return *cached;
+    
+    if (useNativeChain())
+        return pMatrixCache.set(time, getNativePMatrixAtTime(time));
+
+    MTime evalTime(time, MTime::uiUnit());
+    return pMatrixCache.set(time, getPMatrixAtTime(evalTime));
+}
+
+PathSample MotionPath::getSample(const double time, MDGContext &context, const bool allowNative)
+{
+    PathSample sample;
+    
+    const MMatrix *cached = pMatrixCache.find(time);
+    if (cached)
+        sample.pMatrix = *cached;
+    else
+        sample.pMatrix = pMatrixCache.set(time, useNativeChain() ? getNativePMatrixAtTime(time) : getPMatrixAtTime(context));
+    sample.position = allowNative && nativeTranslate ? getNativePos(time) : getPos(context);
+    sample.worldPosition = multPosByParentMatrix(sample.position, sample.pMatrix);
+    
+    return sample;
+}
+
+PathSample MotionPath::getSampleAtTime(const double time)
+{
+    //outside of a draw the curve snapshot might be stale, always go through the DG
+    MDGContext context(MTime(time, MTime::uiUnit()));
+    return getSample(time, context, false);
+}
+
+const PathSample &MotionPath::ensureSampleAtTime(const double time)
+{
+    const PathSample *cached = sampleCache.find(time);
+    if (cached)
+        return *cached;
+    
+    MDGContext context(MTime(time, MTime::uiUnit()));
+    return sampleCache.set(time, getSample(time, context, true));
+}
+
+void MotionPath::cacheSampleAtTime(const double time, MDGContext &context)
+{
+    if (!sampleCache.contains(time))
+        sampleCache.set(time, getSample(time, context, true));
+}
+
+bool MotionPath::hasNativeSamples()
 {
-    if(pMatrixCache.find(time) == pMatrixCache.end())
+    return nativeTranslate && useNativeChain() && !nativePositions.empty();
+}
+
+void MotionPath::computeNativeSamples(const int first, const int count, PathSample *samples, unsigned char *newMatrix) const
+{
+    //same math as getSample, the caches are only read here and get filled in publishNativeSamples.
+    //This runs on the worker threads, nothing in here may touch Maya's globals
+    for (int i = 0; i < count; ++i)
     {
-        MTime evalTime(time, MTime::uiUnit());
-        pMatrixCache[time] = getPMatrixAtTime(evalTime);
+        double time = nativePositionsStart + first + i;
+        PathSample &sample = samples[i];
+        
+        const MMatrix *cached = pMatrixCache.find(time);
+        newMatrix[i] = cached == NULL;
+        sample.pMatrix = cached ? *cached : getNativePMatrixAtSeconds(nativeSeconds[first + i]);
+        sample.position = nativePositions[first + i];
+        sample.worldPosition = multPosByParentMatrix(sample.position, sample.pMatrix);
     }
 }
 
-void MotionPath::cacheKeyFrames(const MFnAnimCurve &curveTX, const MFnAnimCurve &curveTY, const MFnAnimCurve &curveTZ, const MFnAnimCurve &curveRX, const MFnAnimCurve &curveRY, const MFnAnimCurve &curveRZ, CameraCache* cachePtr, const MMatrix &currentCameraMatrix)
+void MotionPath::publishNativeSamples(const std::vector<PathSample> &samples, const std::vector<unsigned char> &newMatrix)
 {
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        double time = nativePositionsStart + i;
+        if (newMatrix[i])
+            pMatrixCache.set(time, samples[i].pMatrix);
+        if (!sampleCache.contains(time))
+            sampleCache.set(time, samples[i]);
+    }
+}
+
+void MotionPath::cacheKeyFrames(const MFnAnimCurve &curveTX, const MFnAnimCurve &curveTY, const MFnAnimCurve &curveTZ, const MFnAnimCurve &curveRX, const MFnAnimCurve &curveRY, const MFnAnimCurve &curveRZ)
+{
+    keyframesCache.clear();
+    ++geometryVersion;
+    
     if (isCurveTypeAnimatable(curveTX.animCurveType()))
         expandKeyFramesCache(curveTX, Keyframe::kAxisX, true);
 
@@ -639,9 +929,6 @@ void MotionPath::cacheKeyFrames(const MFnAnimCurve &curveTX, const MFnAnimCurve
 		Keyframe* key = &keyIt->second;
 		key->id = i;
         
-        if (selectedKeyTimes.find(key->time) != selectedKeyTimes.end())
-            key->selectedFromTool = true;
-        
         //OVERRIDE: if we are drawing, we don't show the tangents to make perfomances faster
         if (isDrawing)
         {
@@ -649,19 +936,66 @@ void MotionPath::cacheKeyFrames(const MFnAnimCurve &curveTX, const MFnAnimCurve
             key->showOutTangent = false;
         }
         
-        ensureParentAndPivotMatrixAtTime(key->time);
+        const PathSample keySample = ensureSampleAtTime(key->time);
+        const MMatrix &keyPMatrix = keySample.pMatrix;
+        
+        key->position = keySample.position;
+        key->pathWorldPosition = keySample.worldPosition;
+        
+		key->inTangentWorld = multPosByParentMatrix((-key->inTangent) + key->position, keyPMatrix);
+		key->outTangentWorld = multPosByParentMatrix(key->outTangent + key->position, keyPMatrix);
+        
+        if (key->showInTangent && !isWeighted)
+            key->inCurveWorldPosition = ensureSampleAtTime(key->time - TANGENT_TIME_DELTA).worldPosition;
+        
+        if (key->showOutTangent && !isWeighted)
+            key->outCurveWorldPosition = ensureSampleAtTime(key->time + TANGENT_TIME_DELTA).worldPosition;
+        
+		i += 1;
+	}
+    
+    keyframesDirty = false;
+    keyframesStartTime = displayStartTime;
+    keyframesEndTime = isDrawing ? endDrawingTime : displayEndTime;
+    keyframesShowRotation = GlobalSettings::showRotationKeyFrames;
+    keyframesDrawing = isDrawing;
+}
+
+bool MotionPath::keyFramesNeedRebuild()
+{
+    if (keyframesDirty)
+        return true;
+    
+    double keysEndTime = isDrawing ? endDrawingTime : displayEndTime;
+    if (keyframesStartTime != displayStartTime || keyframesEndTime != keysEndTime || keyframesShowRotation != GlobalSettings::showRotationKeyFrames || keyframesDrawing != isDrawing)
+        return true;
+    
+    //anything moving the keys without editing the curves (parents, static channels) shows up in the samples of this draw
+    for(KeyframeMapIterator keyIt = keyframesCache.begin(); keyIt != keyframesCache.end(); keyIt++)
+    {
+        Keyframe* key = &keyIt->second;
+        if (!ensureSampleAtTime(key->time).worldPosition.isEquivalent(key->pathWorldPosition, 1e-6))
+            return true;
+    }
+    
+    return false;
+}
+
+void MotionPath::projectKeyFrames(CameraCache* cachePtr, const MMatrix &currentCameraMatrix)
+{
+	for(KeyframeMapIterator keyIt = keyframesCache.begin(); keyIt != keyframesCache.end(); keyIt++)
+	{
+		Keyframe* key = &keyIt->second;
+        
+        key->selectedFromTool = selectedKeyTimes.find(key->time) != selectedKeyTimes.end();
         
-        key->position = getPos(key->time);
-        key->worldPosition = multPosByParentMatrix(key->position, pMatrixCache[key->time]);
+        key->worldPosition = key->pathWorldPosition;
         if (GlobalSettings::motionPathDrawMode == GlobalSettings::kCameraSpace)
         {
             cachePtr->ensureMatricesAtTime(key->time);
             key->worldPosition = MPoint(key->worldPosition) * cachePtr->matrixCache[key->time] * currentCameraMatrix;
         }
         
-		key->inTangentWorld = multPosByParentMatrix((-key->inTangent) + key->position, pMatrixCache[key->time]);
-		key->outTangentWorld = multPosByParentMatrix(key->outTangent + key->position, pMatrixCache[key->time]);
-        
         if (key->showInTangent)
         {
             if (isWeighted)
@@ -669,15 +1003,14 @@ void MotionPath::cacheKeyFrames(const MFnAnimCurve &curveTX, const MFnAnimCurve
             else
             {
                 double prevTime = key->time - TANGENT_TIME_DELTA;
-                ensureParentAndPivotMatrixAtTime(prevTime);
                 
                 MVector inWorldPosition;
                 if (GlobalSettings::motionPathDrawMode == GlobalSettings::kWorldSpace)
-                    inWorldPosition = multPosByParentMatrix(getPos(prevTime), pMatrixCache[prevTime]) - key->worldPosition;
+                    inWorldPosition = key->inCurveWorldPosition - key->worldPosition;
                 else
                 {
                     cachePtr->ensureMatricesAtTime(prevTime, true);
-                    inWorldPosition = MVector(MPoint(multPosByParentMatrix(getPos(prevTime), pMatrixCache[prevTime])) * cachePtr->matrixCache[prevTime] * currentCameraMatrix) - key->worldPosition;
+                    inWorldPosition = MVector(MPoint(key->inCurveWorldPosition) * cachePtr->matrixCache[prevTime] * currentCameraMatrix) - key->worldPosition;
                 }
                 
                 inWorldPosition.normalize();
@@ -692,23 +1025,20 @@ void MotionPath::cacheKeyFrames(const MFnAnimCurve &curveTX, const MFnAnimCurve
             else
             {
                 double afterTime = key->time + TANGENT_TIME_DELTA;
-                ensureParentAndPivotMatrixAtTime(afterTime);
                 
-                MVector outWorldPosition = multPosByParentMatrix(getPos(afterTime), pMatrixCache[afterTime]) - key->worldPosition;
+                MVector outWorldPosition;
                 if (GlobalSettings::motionPathDrawMode == GlobalSettings::kWorldSpace)
-                    outWorldPosition = multPosByParentMatrix(getPos(afterTime), pMatrixCache[afterTime]) - key->worldPosition;
+                    outWorldPosition = key->outCurveWorldPosition - key->worldPosition;
                 else
                 {
                     cachePtr->ensureMatricesAtTime(afterTime, true);
-                    outWorldPosition = MVector(MPoint(multPosByParentMatrix(getPos(afterTime), pMatrixCache[afterTime])) * cachePtr->matrixCache[afterTime] * currentCameraMatrix) - key->worldPosition;
+                    outWorldPosition = MVector(MPoint(key->outCurveWorldPosition) * cachePtr->matrixCache[afterTime] * currentCameraMatrix) - key->worldPosition;
                 }
                 
                 outWorldPosition.normalize();
                 key->outTangentWorldFromCurve = outWorldPosition * key->outTangent.length() + key->worldPosition;
             }
         }
-        
-		i += 1;
 	}
 }
 
@@ -721,41 +1051,29 @@ void MotionPath::drawTangents(M3dView &view, MMatrix& currentCameraMatrix, MHWRe
     if ((QApplication::mouseButtons() != Qt::NoButton) && (QApplication::keyboardModifiers() == Qt::AltModifier))
         return;
     
-	MColor tangentColor;
+    //filled by drawFrames together with the path
+    if (!drawManager)
+    {
+        drawUtils::drawPathGeometry(legacyGeometry, PathGeometry::kTangents, GL_LINES, 1.0);
+        drawUtils::drawPathGeometry(legacyGeometry, PathGeometry::kHandles, GL_POINTS, GlobalSettings::frameSize);
+        return;
+    }
+    
 	for(KeyframeMapIterator keyIt = keyframesCache.begin(); keyIt != keyframesCache.end(); keyIt++)
 	{
 		Keyframe* key = &keyIt->second;
-        if (isWeighted)
-            tangentColor = GlobalSettings::weightedPathTangentColor;
-        else
-            tangentColor = key->tangentsLocked ? GlobalSettings::tangentColor : GlobalSettings::brokenTangentColor;
+        MColor tangentColor = getTangentColor(key);
         
         if (key->showInTangent)
         {
-			if (drawManager)
-			{
-				VP2DrawUtils::drawLineWithColor(key->worldPosition, key->inTangentWorldFromCurve, 1.0, tangentColor, currentCameraMatrix, drawManager, frameContext);
-				VP2DrawUtils::drawPointWithColor(key->inTangentWorldFromCurve, GlobalSettings::frameSize, tangentColor, currentCameraMatrix, drawManager, frameContext);
-			}
-			else
-			{
-				drawUtils::drawLineWithColor(key->worldPosition, key->inTangentWorldFromCurve, 1.0, tangentColor);
-				drawUtils::drawPointWithColor(key->inTangentWorldFromCurve, GlobalSettings::frameSize, tangentColor);
-			}
+			VP2DrawUtils::drawLineWithColor(key->worldPosition, key->inTangentWorldFromCurve, 1.0, tangentColor, GlobalSettings::screenProjector, drawManager);
+			VP2DrawUtils::drawPointWithColor(key->inTangentWorldFromCurve, GlobalSettings::frameSize, tangentColor, GlobalSettings::screenProjector, drawManager);
         }
         
         if (key->showOutTangent)
 		{
-			if (drawManager)
-			{
-				VP2DrawUtils::drawLineWithColor(key->worldPosition, key->outTangentWorldFromCurve, 1.0, tangentColor, currentCameraMatrix, drawManager, frameContext);
-				VP2DrawUtils::drawPointWithColor(key->outTangentWorldFromCurve, GlobalSettings::frameSize, tangentColor, currentCameraMatrix, drawManager, frameContext);
-			}
-			else
-			{
-				drawUtils::drawLineWithColor(key->worldPosition, key->outTangentWorldFromCurve, 1.0, tangentColor);
-				drawUtils::drawPointWithColor(key->outTangentWorldFromCurve, GlobalSettings::frameSize, tangentColor);
-			}
+			VP2DrawUtils::drawLineWithColor(key->worldPosition, key->outTangentWorldFromCurve, 1.0, tangentColor, GlobalSettings::screenProjector, drawManager);
+			VP2DrawUtils::drawPointWithColor(key->outTangentWorldFromCurve, GlobalSettings::frameSize, tangentColor, GlobalSettings::screenProjector, drawManager);
         }
 	}
 }
@@ -775,7 +1093,7 @@ void MotionPath::drawFrameLabels(M3dView &view, CameraCache* cachePtr, const MMa
         else if (!hasKey && !GlobalSettings::showFrameNumbers)
             continue;
         
-   		MVector worldPos = multPosByParentMatrix(getPos(i), pMatrixCache[i]);
+   		MVector worldPos = ensureSampleAtTime(i).worldPosition;
         if (GlobalSettings::motionPathDrawMode == GlobalSettings::kCameraSpace)
         {
             cachePtr->ensureMatricesAtTime(i);
@@ -783,11 +1101,9 @@ void MotionPath::drawFrameLabels(M3dView &view, CameraCache* cachePtr, const MMa
         }
         
         double offset = hasKey ? 1.1 : 0.8;
-
-		if (drawManager)
-			VP2DrawUtils::drawFrameLabel(i, worldPos, view, offset, labelColor, currentCameraMatrix, drawManager, frameContext);
-		else
-			drawUtils::drawFrameLabel(i, worldPos, view, offset, labelColor, currentCameraMatrix);
+        
+        //placed and drawn by the manager once every path of the panel has added its labels
+        mpManager.getLabelPlacer().addLabel(i, worldPos, offset, labelColor, LabelPlacer::priorityForFrame(i, hasKey));
 	}
 }
 
@@ -799,9 +1115,7 @@ void MotionPath::drawCurrentFrame(CameraCache* cachePtr, const MMatrix &currentC
 	MTime currentTime = MAnimControl::currentTime();
 	double currentTimeValue = currentTime.as(MTime::uiUnit());
     
-    ensureParentAndPivotMatrixAtTime(currentTimeValue);
-    
-    MVector worldPos = multPosByParentMatrix(getPos(currentTimeValue), this->pMatrixCache[currentTimeValue]);
+    MVector worldPos = ensureSampleAtTime(currentTimeValue).worldPosition;
     if (GlobalSettings::motionPathDrawMode == GlobalSettings::kCameraSpace)
     {
         cachePtr->ensureMatricesAtTime(currentTimeValue);
@@ -809,26 +1123,27 @@ void MotionPath::drawCurrentFrame(CameraCache* cachePtr, const MMatrix &currentC
     } 
     
 	if (drawManager) 
-		VP2DrawUtils::drawPointWithColor(worldPos, GlobalSettings::frameSize * 2.2, frameColor, currentCameraMatrix, drawManager, frameContext);
+		VP2DrawUtils::drawPointWithColor(worldPos, GlobalSettings::frameSize * 2.2, frameColor, GlobalSettings::screenProjector, drawManager);
 	else
 		drawUtils::drawPointWithColor(worldPos, GlobalSettings::frameSize * 2.2, frameColor);
 }
 
-void MotionPath::drawPath(M3dView &view, CameraCache* cachePtr, const MMatrix &currentCameraMatrix, const bool selecting, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
-{    
-    drawFrames(cachePtr, GlobalSettings::cameraMatrix, view, drawManager, frameContext);
+void MotionPath::drawPath(M3dView &view, CameraCache* cachePtr, const MMatrix &currentCameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
+{
+    //the lines, frames and tangents already sit in the vertex buffers of the geometry node
+    bool persistent = drawManager && mpManager.persistentGeometryActive();
     
-    if (!selecting)
-    {
-        drawCurrentFrame(cachePtr, GlobalSettings::cameraMatrix, view, drawManager, frameContext);
+    if (!persistent)
+        drawFrames(cachePtr, GlobalSettings::cameraMatrix, view, drawManager, frameContext);
     
-        if (GlobalSettings::showKeyFrameNumbers || GlobalSettings::showFrameNumbers)
-            drawFrameLabels(view, cachePtr, GlobalSettings::cameraMatrix, drawManager, frameContext);
-    }
+    drawCurrentFrame(cachePtr, GlobalSettings::cameraMatrix, view, drawManager, frameContext);
+    
+    if ((GlobalSettings::showKeyFrameNumbers || GlobalSettings::showFrameNumbers) && mpManager.getDrawLevel() < DrawGovernor::kNoLabels)
+        drawFrameLabels(view, cachePtr, GlobalSettings::cameraMatrix, drawManager, frameContext);
     
     if (GlobalSettings::showKeyFrames && keyframesCache.size() > 0)
     {
-        if (GlobalSettings::showTangents)
+        if (GlobalSettings::showTangents && !persistent && mpManager.getDrawLevel() < DrawGovernor::kNoTangents)
             drawTangents(view, GlobalSettings::cameraMatrix, drawManager, frameContext);
         
         // we want the keyframes to appear on the top of everything
@@ -836,25 +1151,8 @@ void MotionPath::drawPath(M3dView &view, CameraCache* cachePtr, const MMatrix &c
     }
 }
 
-void MotionPath::draw(M3dView &view, CameraCache* cachePtr, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
+void MotionPath::beginDraw()
 {
-    MTime currentTime = MAnimControl::currentTime();
-    
-    MStatus xStatus, yStatus, zStatus;
-	MFnAnimCurve curveX(txPlug, &xStatus);
-	MFnAnimCurve curveY(tyPlug, &yStatus);
-	MFnAnimCurve curveZ(tzPlug, &zStatus);
-    MFnAnimCurve curveRotX(rxPlug);
-	MFnAnimCurve curveRotY(ryPlug);
-	MFnAnimCurve curveRotZ(rzPlug);
-    
-    //storing values to keep the curve appear like it was edited in real time (won't happen if autoKeyFrame is off)
-    double newXValue, newYValue, newZValue;
-    double oldXValue, oldYValue, oldZValue;
-    int newKeyX, newKeyY, newKeyZ;
-    int oldKeyX, oldKeyY, oldKeyZ;
-    bool xUpdated=false, yUpdated=false, zUpdated=false;
-    
     //Refreshing the parent matrix cache if we need to do so
     if (GlobalSettings::lockedMode && GlobalSettings::lockedModeInteractive && getWorldSpaceCallbackCalled())
     {
@@ -866,46 +1164,260 @@ void MotionPath::draw(M3dView &view, CameraCache* cachePtr, MHWRender::MUIDrawMa
         }
     }
     
+    //samples are only valid for the duration of a draw as the curves might have been edited in between
+    sampleCache.clear();
+    
+    MDagPath dp;
+    MDagPath::getAPathTo(thisObject, dp);
+    drawWorldMatrix = dp.inclusiveMatrix();
+    
+    nativeTranslate = false;
+    
+    if (constrained)
+        return;
+    
+    //plain time curves are evaluated by us, anything else goes through the DG.
+    //Reading and validating the curves is only done again once they could have changed, playback reuses the snapshots
+    MPlug *plugs[3] = {&txPlug, &tyPlug, &tzPlug};
+    if (translateSnapshotsStale())
+    {
+        translateSnapshotsNative = true;
+        for (int i = 0; i < 3; ++i)
+            translateSnapshotsNative = translateSnapshots[i].snapshot(*plugs[i]) && translateSnapshotsNative;
+        
+        translateSnapshotsValid = true;
+        translateSnapshotsVersion = mpManager.getSceneVersion();
+    }
+    
+    nativeTranslate = translateSnapshotsNative;
+    if (!nativeTranslate)
+        return;
+    
+    for (int i = 0; i < 3; ++i)
+        translateEvaluators[i] = translateSnapshots[i];
+    
+    //values that were not keyed yet are overlaid on our snapshot so that the path follows the object, the scene curves are never touched.
+    //When going through the DG they only show up at the current frame
+    MTime currentTime = MAnimControl::currentTime();
+    for (int i = 0; i < 3; ++i)
+        translateEvaluators[i].overlayLiveValue(*plugs[i], currentTime);
+    
+    for (std::map<double, MVector>::iterator it = previewOffsets.begin(); it != previewOffsets.end(); ++it)
+        offsetNativeKey(it->first, it->second);
+    
+    cacheNativePositions();
+}
+
+bool MotionPath::translateSnapshotsStale()
+{
+    if (!translateSnapshotsValid || translateSnapshotsVersion != mpManager.getSceneVersion())
+        return true;
+    
+    //our own curve writes flag the keys before the curve edited callback comes in, the drag preview only touches the copies
+    return keyframesDirty && previewOffsets.empty();
+}
+
+void MotionPath::cacheNativePositions()
+{
+    nativePositionsStart = displayStartTime;
+    
+    int count = static_cast<int>(displayEndTime - displayStartTime) + 1;
+    if (count <= 0)
+    {
+        nativePositions.clear();
+        nativeSeconds.clear();
+        return;
+    }
+    
+    double start = MTime(displayStartTime, MTime::uiUnit()).as(MTime::kSeconds);
+    double step = MTime(1.0, MTime::uiUnit()).as(MTime::kSeconds);
+    
+    nativeSeconds.resize(count);
+    for (int i = 0; i < count; ++i)
+        nativeSeconds[i] = MTime(displayStartTime + i, MTime::uiUnit()).as(MTime::kSeconds);
+    
+    std::vector<double> values(count);
+    nativePositions.assign(count, MVector::zero);
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        translateEvaluators[axis].evaluateRange(start, step, count, &values[0]);
+        for (int i = 0; i < count; ++i)
+            nativePositions[i][axis] = values[i];
+    }
+}
+
+MVector MotionPath::getNativePos(const double time)
+{
+    double offset = time - nativePositionsStart;
+    int index = static_cast<int>(std::floor(offset + 0.5));
+    if (index >= 0 && index < static_cast<int>(nativePositions.size()) && std::fabs(offset - index) < 1e-6)
+        return nativePositions[index];
+    
+    double seconds = MTime(time, MTime::uiUnit()).as(MTime::kSeconds);
+    return MVector(translateEvaluators[0].evaluate(seconds), translateEvaluators[1].evaluate(seconds), translateEvaluators[2].evaluate(seconds));
+}
+
+void MotionPath::offsetNativeKey(const double time, const MVector &offset)
+{
+    double seconds = MTime(time, MTime::uiUnit()).as(MTime::kSeconds);
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        if (offset[axis] != 0.0)
+            translateEvaluators[axis].offsetKey(seconds, offset[axis]);
+    }
+}
+
+void MotionPath::refreshNativeSamples()
+{
+    //the parent matrices did not change, only the local positions of the cached samples are evaluated again
+    ++geometryVersion;
+    cacheNativePositions();
+    for (size_t i = 0; i < nativePositions.size(); ++i)
+        refreshNativeSample(nativePositionsStart + i);
+    
+    for(KeyframeMapIterator keyIt = keyframesCache.begin(); keyIt != keyframesCache.end(); keyIt++)
+    {
+        refreshNativeSample(keyIt->first - TANGENT_TIME_DELTA);
+        refreshNativeSample(keyIt->first + TANGENT_TIME_DELTA);
+    }
+}
+
+void MotionPath::refreshNativeSample(const double time)
+{
+    PathSample *sample = sampleCache.find(time);
+    if (!sample)
+        return;
+    
+    sample->position = getNativePos(time);
+    sample->worldPosition = multPosByParentMatrix(sample->position, sample->pMatrix);
+}
+
+bool MotionPath::liveValuesChanged()
+{
+    if (getWorldSpaceCallbackCalled())
+        return true;
+    
+    MDagPath dp;
+    MDagPath::getAPathTo(thisObject, dp);
+    return !dp.inclusiveMatrix().isEquivalent(drawWorldMatrix, 1e-10);
+}
+
+MMatrix MotionPath::getCurrentCameraMatrix(CameraCache* cachePtr)
+{
     MMatrix currentCameraMatrix;
     if (GlobalSettings::motionPathDrawMode == GlobalSettings::kCameraSpace)
     {
         double currentTime = MAnimControl::currentTime().as(MTime::uiUnit());
         currentCameraMatrix = cachePtr->matrixCache[currentTime].inverse();
     }
+    return currentCameraMatrix;
+}
+
+void MotionPath::prepareKeyFrames(CameraCache* cachePtr)
+{
+    if (constrained)
+        return;
     
-    if (!constrained)
+    //the keys only get rebuilt when their curves or range changed, camera moves just reproject them
+    if (keyFramesNeedRebuild())
     {
-        xUpdated = animCurveUtils::updateCurve(txPlug, curveX, currentTime, oldXValue, newXValue, newKeyX, oldKeyX);
-        yUpdated = animCurveUtils::updateCurve(tyPlug, curveY, currentTime, oldYValue, newYValue, newKeyY, oldKeyY);
-        zUpdated = animCurveUtils::updateCurve(tzPlug, curveZ, currentTime, oldZValue, newZValue, newKeyZ, oldKeyZ);
+        //a curve write caught here before any beginDraw saw it, the next one has to read the curves again
+        if (translateSnapshotsStale())
+            translateSnapshotsValid = false;
+        
+        MFnAnimCurve curveX(txPlug);
+        MFnAnimCurve curveY(tyPlug);
+        MFnAnimCurve curveZ(tzPlug);
+        MFnAnimCurve curveRotX(rxPlug);
+        MFnAnimCurve curveRotY(ryPlug);
+        MFnAnimCurve curveRotZ(rzPlug);
         
         isWeighted = curveX.isWeighted() || curveY.isWeighted() || curveZ.isWeighted();
         
-        keyframesCache.clear();
-
-        cacheKeyFrames(curveX, curveY, curveZ, curveRotX, curveRotY, curveRotZ, cachePtr, currentCameraMatrix);
+        cacheKeyFrames(curveX, curveY, curveZ, curveRotX, curveRotY, curveRotZ);
     }
     
-    drawPath(view, cachePtr, currentCameraMatrix, false, drawManager, frameContext);
-     
-    //restoring the previous values if a keyframe was not actually set by the user
-    if (xUpdated && xStatus != MS::kNotFound)
-    {
-        animCurveUtils::restoreCurve(curveX, currentTime, oldXValue, newKeyX, oldKeyX);
-        this->txPlug.setValue(newXValue);
-    }
-    if (yUpdated && yStatus != MS::kNotFound)
+    projectKeyFrames(cachePtr, getCurrentCameraMatrix(cachePtr));
+}
+
+void MotionPath::fillGeometry(PathGeometry &geometry, CameraCache* cachePtr, const ScreenProjector* projector)
+{
+    geometry.clear();
+    
+    MColor curveColor = getPathColor();
+    
+    MPointArray points;
+    collectFramePoints(cachePtr, GlobalSettings::cameraMatrix, points);
+    
+    std::vector<unsigned char> keepLine(points.length(), 1), keepDots(points.length(), 1);
+    if (projector)
+        simplifyFrames(points, *projector, keepLine, keepDots);
+    else
+        thinFrames(keepLine, keepDots);
+    
+    unsigned int previous = 0;
+    for (unsigned int j = 0; j < points.length(); ++j)
     {
-        animCurveUtils::restoreCurve(curveY, currentTime, oldYValue, newKeyY, oldKeyY);
-        this->tyPlug.setValue(newYValue);
+        if (keepDots[j])
+            geometry.addVertex(PathGeometry::kFrames, points[j], curveColor);
+        
+        //segments are not shared so that every one of them can have its own color
+        if (!GlobalSettings::showPath || j == 0)
+            continue;
+        
+        if (GlobalSettings::alternatingFrames)
+        {
+            double factor = int(displayStartTime + j) % 2 == 1 ? 1.4 : 0.6;
+            geometry.addVertex(PathGeometry::kPath, points[j - 1], curveColor * factor);
+            geometry.addVertex(PathGeometry::kPath, points[j], curveColor * factor);
+        }
+        else if (keepLine[j])
+        {
+            geometry.addVertex(PathGeometry::kPath, points[previous], curveColor);
+            geometry.addVertex(PathGeometry::kPath, points[j], curveColor);
+            previous = j;
+        }
     }
-    if (zUpdated && zStatus != MS::kNotFound )
+    
+    if (!GlobalSettings::showKeyFrames || !GlobalSettings::showTangents || mpManager.getDrawLevel() >= DrawGovernor::kNoTangents)
+        return;
+    
+    for(KeyframeMapIterator keyIt = keyframesCache.begin(); keyIt != keyframesCache.end(); keyIt++)
     {
-        animCurveUtils::restoreCurve(curveZ, currentTime, oldZValue, newKeyZ, oldKeyZ);
-        this->tzPlug.setValue(newZValue);
+        Keyframe* key = &keyIt->second;
+        MColor tangentColor = getTangentColor(key);
+        
+        if (key->showInTangent)
+        {
+            geometry.addVertex(PathGeometry::kTangents, key->worldPosition, tangentColor);
+            geometry.addVertex(PathGeometry::kTangents, key->inTangentWorldFromCurve, tangentColor);
+            geometry.addVertex(PathGeometry::kHandles, key->inTangentWorldFromCurve, tangentColor);
+        }
+        
+        if (key->showOutTangent)
+        {
+            geometry.addVertex(PathGeometry::kTangents, key->worldPosition, tangentColor);
+            geometry.addVertex(PathGeometry::kTangents, key->outTangentWorldFromCurve, tangentColor);
+            geometry.addVertex(PathGeometry::kHandles, key->outTangentWorldFromCurve, tangentColor);
+        }
     }
-    
+}
 
+unsigned int MotionPath::getGeometryStamp(const unsigned int sceneStamp)
+{
+    //the samples only change with the scene, which sceneStamp covers, or when the object moved under us
+    unsigned int stamp = sceneStamp;
+    PathGeometry::addToStamp(stamp, &geometryVersion, sizeof(geometryVersion));
+    PathGeometry::addToStamp(stamp, &colorMultiplier, sizeof(colorMultiplier));
+    PathGeometry::addToStamp(stamp, &selectedFromTool, sizeof(selectedFromTool));
+    PathGeometry::addToStamp(stamp, &isWeighted, sizeof(isWeighted));
+    PathGeometry::addToStamp(stamp, drawWorldMatrix.matrix, sizeof(drawWorldMatrix.matrix));
+    return stamp;
+}
+
+void MotionPath::draw(M3dView &view, CameraCache* cachePtr, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
+{
+    drawPath(view, cachePtr, getCurrentCameraMatrix(cachePtr), drawManager, frameContext);
 }
 
 double MotionPath::getTimeFromKeyId(const int id)
@@ -957,26 +1469,31 @@ void MotionPath::getBoundariesForTime(const double time, double *minBoundary, do
 
 void MotionPath::deleteKeyFramesAfterTime(const double time, MFnAnimCurve &curve, MAnimCurveChange *change)
 {
-    for (int i = curve.numKeys() - 1; i >= 0; --i)
-    {
-        MTime mtime = curve.time(i);
-        if (mtime.as(MTime::uiUnit()) > time)
-            curve.remove(i, change);
-    }
+    keyframesDirty = true;
+    
+    //keys are sorted, we stop at the first one that stays
+    for (int i = curve.numKeys() - 1; i >= 0 && curve.time(i).as(MTime::uiUnit()) > time; --i)
+        curve.remove(i, change);
 }
 
 void MotionPath::deleteKeyFramesBetweenTimes(const double startTime, const double endTime, MFnAnimCurve &curve, MAnimCurveChange *change)
 {
+    keyframesDirty = true;
+    
     for (int i = curve.numKeys() - 1; i >= 0; --i)
     {
         double t = curve.time(i).as(MTime::uiUnit());
-        if (t > startTime && t < endTime)
+        if (t <= startTime)
+            break;
+        if (t < endTime)
             curve.remove(i, change);
     }
 }
 
 void MotionPath::deleteAllKeyFramesAfterTime(const double time, MAnimCurveChange *change)
 {
+    keyframesDirty = true;
+    
     MFnAnimCurve curveX(txPlug);
 	MFnAnimCurve curveY(tyPlug);
 	MFnAnimCurve curveZ(tzPlug);
@@ -999,6 +1516,8 @@ void MotionPath::getKeyWorldPosition(const double keyTime, MVector &keyWorldPosi
 
 void MotionPath::deleteKeyFrameWithId(const int id, MAnimCurveChange *change)
 {
+    keyframesDirty = true;
+    
     MFnAnimCurve curveX(txPlug);
 	MFnAnimCurve curveY(tyPlug);
 	MFnAnimCurve curveZ(tzPlug);
@@ -1021,6 +1540,8 @@ void MotionPath::deleteKeyFrameWithId(const int id, MAnimCurveChange *change)
 
 void MotionPath::deleteKeyFrameAtTime(const double time, MAnimCurveChange *change, const bool useCache)
 {
+    keyframesDirty = true;
+    
     MFnAnimCurve curveX(txPlug);
     MFnAnimCurve curveY(tyPlug);
     MFnAnimCurve curveZ(tzPlug);
@@ -1058,6 +1579,8 @@ void MotionPath::deleteKeyFrameAtTime(const double time, MAnimCurveChange *chang
 
 void MotionPath::addKeyFrameAtTime(const double time, MAnimCurveChange *change, MVector *position, const bool useCache)
 {
+    keyframesDirty = true;
+    
     MFnAnimCurve curveX(txPlug);
 	MFnAnimCurve curveY(tyPlug);
 	MFnAnimCurve curveZ(tzPlug);
@@ -1067,8 +1590,7 @@ void MotionPath::addKeyFrameAtTime(const double time, MAnimCurveChange *change,
         pos = getPos(time);
     else
     {
-        ensureParentAndPivotMatrixAtTime(time);
-        pos = multPosByParentMatrix(*position, pMatrixCache[time].inverse());
+        pos = multPosByParentMatrix(*position, ensureParentAndPivotMatrixAtTime(time).inverse());
     }
     
     MTime mtime(time, MTime::uiUnit());
@@ -1099,14 +1621,15 @@ void MotionPath::addKeyFrameAtTime(const double time, MAnimCurveChange *change,
 
 void MotionPath::setFrameWorldPosition(const MVector &position, const double time, MAnimCurveChange *change)
 {
+    keyframesDirty = true;
+    
     KeyframeMapIterator keyIt = keyframesCache.find(time);
 	if(keyIt == keyframesCache.end())
         return;
     
 	Keyframe* key = &keyIt->second;
     
-    ensureParentAndPivotMatrixAtTime(time);
-	MVector lPos = multPosByParentMatrix(position, pMatrixCache[time].inverse());
+	MVector lPos = multPosByParentMatrix(position, ensureParentAndPivotMatrixAtTime(time).inverse());
     
 	MFnAnimCurve curveX(txPlug);
 	MFnAnimCurve curveY(tyPlug);
@@ -1122,14 +1645,15 @@ void MotionPath::setFrameWorldPosition(const MVector &position, const double tim
 
 void MotionPath::offsetWorldPosition(const MVector &offset, const double time, MAnimCurveChange *change)
 {
+    keyframesDirty = true;
+    
     KeyframeMapIterator keyIt = keyframesCache.find(time);
 	if(keyIt == keyframesCache.end())
         return;
     
 	Keyframe* key = &keyIt->second;
     
-    ensureParentAndPivotMatrixAtTime(time);
-    MVector lOffset = offset * pMatrixCache[time].inverse();
+    MVector lOffset = offset * ensureParentAndPivotMatrixAtTime(time).inverse();
     
     MFnAnimCurve curveX(txPlug);
 	MFnAnimCurve curveY(tyPlug);
@@ -1155,8 +1679,144 @@ void MotionPath::offsetWorldPosition(const MVector &offset, const double time, M
     }
 }
 
+void MotionPath::applyKeyEdits(const std::vector<KeyEdit> &edits, MAnimCurveChange *change)
+{
+    if (edits.empty())
+        return;
+    
+    keyframesDirty = true;
+    
+    //local values of every edit, each parent matrix is inverted once for the whole batch
+    std::vector<MVector> values(edits.size());
+    std::map<double, MMatrix> inverseMatrices;
+    for (size_t i = 0; i < edits.size(); ++i)
+    {
+        const KeyEdit &edit = edits[i];
+        if (edit.operation != KeyEdit::kSet)
+        {
+            values[i] = edit.position;
+            continue;
+        }
+        
+        std::map<double, MMatrix>::iterator it = inverseMatrices.find(edit.time);
+        if (it == inverseMatrices.end())
+            it = inverseMatrices.insert(std::make_pair(edit.time, ensureParentAndPivotMatrixAtTime(edit.time).inverse())).first;
+        values[i] = multPosByParentMatrix(edit.position, it->second);
+    }
+    
+    MPlug *plugs[3] = {&txPlug, &tyPlug, &tzPlug};
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        MStatus status;
+        MFnAnimCurve curve(*plugs[axis], &status);
+        if (status)
+            applyKeyEditsOnCurve(curve, axis, edits, values, change);
+    }
+}
+
+void MotionPath::applyKeyEditsOnCurve(MFnAnimCurve &curve, const unsigned int axis, const std::vector<KeyEdit> &edits, const std::vector<MVector> &values, MAnimCurveChange *change)
+{
+    //removed from the last index down so that the indices found up front stay valid
+    std::vector<unsigned int> removed;
+    for (size_t i = 0; i < edits.size(); ++i)
+    {
+        unsigned int index;
+        if (edits[i].operation == KeyEdit::kDelete && curve.find(MTime(edits[i].time, MTime::uiUnit()), index))
+            removed.push_back(index);
+    }
+    
+    std::sort(removed.begin(), removed.end());
+    removed.erase(std::unique(removed.begin(), removed.end()), removed.end());
+    for (size_t i = removed.size(); i > 0; --i)
+        curve.remove(removed[i - 1], change);
+    
+    //existing keys are edited in place, the missing ones are added with a single call
+    std::map<double, double> newKeys;
+    for (size_t i = 0; i < edits.size(); ++i)
+    {
+        const KeyEdit &edit = edits[i];
+        if (edit.operation == KeyEdit::kDelete)
+            continue;
+        
+        unsigned int index;
+        if (curve.find(MTime(edit.time, MTime::uiUnit()), index))
+            curve.setValue(index, edit.operation == KeyEdit::kOffset ? curve.value(index) + values[i][axis] : values[i][axis], change);
+        else if (edit.operation == KeyEdit::kSet)
+            newKeys[edit.time] = values[i][axis];
+    }
+    
+    if (newKeys.empty())
+        return;
+    
+    MTimeArray times;
+    MDoubleArray keyValues;
+    for (std::map<double, double>::const_iterator it = newKeys.begin(); it != newKeys.end(); ++it)
+    {
+        times.append(MTime(it->first, MTime::uiUnit()));
+        keyValues.append(it->second);
+    }
+    curve.addKeys(&times, &keyValues, MFnAnimCurve::kTangentGlobal, MFnAnimCurve::kTangentGlobal, true, change);
+}
+
+bool MotionPath::previewOffsetWorldPosition(const MVector &offset, const double time)
+{
+    //paths going through the DG only see the change once it is on the curves
+    if (!nativeTranslate)
+        return false;
+    
+    KeyframeMapIterator keyIt = keyframesCache.find(time);
+	if(keyIt == keyframesCache.end())
+        return false;
+    
+	Keyframe* key = &keyIt->second;
+    
+    MVector keyOffset(key->xKeyId != -1 ? offset.x : 0.0, key->yKeyId != -1 ? offset.y : 0.0, key->zKeyId != -1 ? offset.z : 0.0);
+    
+    //all or nothing, an axis moved on the snapshot while another one gets written would be offset twice
+    double seconds = MTime(time, MTime::uiUnit()).as(MTime::kSeconds);
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+        if (keyOffset[axis] != 0.0 && !translateEvaluators[axis].canOffsetKey(seconds))
+            return false;
+    }
+    
+    previewOffsets[time] += keyOffset;
+    
+    //the segments around the key are splined again on the snapshot
+    offsetNativeKey(time, keyOffset);
+    
+    previewSamplesDirty = true;
+    keyframesDirty = true;
+    return true;
+}
+
+void MotionPath::refreshPreviewSamples()
+{
+    if (!previewSamplesDirty)
+        return;
+    
+    previewSamplesDirty = false;
+    refreshNativeSamples();
+}
+
+void MotionPath::commitPreviewOffsets(MAnimCurveChange *change)
+{
+    if (previewOffsets.empty())
+        return;
+    
+    //a single write per key for the whole drag
+    std::vector<KeyEdit> edits;
+    for (std::map<double, MVector>::iterator it = previewOffsets.begin(); it != previewOffsets.end(); ++it)
+        edits.push_back(KeyEdit(KeyEdit::kOffset, it->first, it->second));
+    
+    previewOffsets.clear();
+    applyKeyEdits(edits, change);
+}
+
 void MotionPath::copyKeyFrameFromToOnCurve(MFnAnimCurve &curve, int keyId, double value, double time, MAnimCurveChange *change)
 {
+    keyframesDirty = true;
+    
     double inW, outW;
     MAngle inAngle, outAngle;
 
@@ -1185,6 +1845,8 @@ void MotionPath::copyKeyFrameFromToOnCurve(MFnAnimCurve &curve, int keyId, doubl
 
 void MotionPath::copyKeyFrameFromTo(const double from, const double to, const MVector &cachedPosition, MAnimCurveChange *change)
 {
+    keyframesDirty = true;
+    
     KeyframeMapIterator keyIt = keyframesCache.find(from);
 	if(keyIt == keyframesCache.end())
         return;
@@ -1211,6 +1873,8 @@ void MotionPath::copyKeyFrameFromTo(const double from, const double to, const MV
 
 void MotionPath::setTangentWorldPosition(const MVector &position, const double time, Keyframe::Tangent tangentId, const MMatrix &toWorldMatrix, MAnimCurveChange *change)
 {
+    keyframesDirty = true;
+    
 
     KeyframeMapIterator keyIt = keyframesCache.find(time);
 	if(keyIt == keyframesCache.end())
@@ -1222,7 +1886,7 @@ void MotionPath::setTangentWorldPosition(const MVector &position, const double t
     
     if (isWeighted)
     {
-        localPosition = (position - key->worldPosition) * pMatrixCache[time].inverse();
+        localPosition = (position - key->worldPosition) * ensureParentAndPivotMatrixAtTime(time).inverse();
     }
     else
     {
@@ -1246,7 +1910,7 @@ void MotionPath::setTangentWorldPosition(const MVector &position, const double t
         else
             tangentVector = key->outTangentWorld - MVector(MPoint(key->worldPosition) * toWorldMatrix);
         
-        localPosition = tangentVector.rotateBy(rotation) * pMatrixCache[time].inverse();
+        localPosition = tangentVector.rotateBy(rotation) * ensureParentAndPivotMatrixAtTime(time).inverse();
         localPosition *= lenMultiplier;
     }
     
@@ -1312,86 +1976,9 @@ void MotionPath::getTangentHandleWorldPosition(const double keyTime, const Keyfr
 	}
 }
 
-void MotionPath::drawTangentsForSelection(M3dView &view, CameraCache *cachePtr)
-{
-    for(KeyframeMapIterator keyIt = keyframesCache.begin(); keyIt != keyframesCache.end(); keyIt++)
-    {
-        Keyframe* key = &keyIt->second;
-        
-        view.pushName(key->id);
-        
-        if (key->showInTangent)
-        {
-            view.pushName((int)Keyframe::kInTangent);
-            drawUtils::drawPoint(key->inTangentWorldFromCurve, GlobalSettings::frameSize);
-            view.popName();
-        }
-        
-        if (key->showOutTangent)
-        {
-            view.pushName((int)Keyframe::kOutTangent);
-            drawUtils::drawPoint(key->outTangentWorldFromCurve, GlobalSettings::frameSize);
-            view.popName();
-        }
-        
-        view.popName();
-    }
-}
-
 MVector MotionPath::getWorldPositionAtTime(const double time)
 {
-    ensureParentAndPivotMatrixAtTime(time);
-    return multPosByParentMatrix(getPos(time), pMatrixCache[time]);
-}
-
-void MotionPath::drawKeysForSelection(M3dView &view, CameraCache* cachePtr)
-{
-
-    for(KeyframeMapIterator keyIt = keyframesCache.begin(); keyIt != keyframesCache.end(); keyIt++)
-    {
-        Keyframe* key = &keyIt->second;
-        
-        view.pushName(key->id);
-        drawUtils::drawPoint(key->worldPosition, GlobalSettings::frameSize * 1.2);
-        view.popName();
-    }
-
-}
-
-void MotionPath::drawFramesForSelection(M3dView &view, CameraCache* cachePtr)
-{
-    MVector pos;
-    for(double i = displayStartTime; i <= displayEndTime; i += 1.0)
-    {
-        ensureParentAndPivotMatrixAtTime(i);
-        
-        view.pushName(static_cast<int>(i));
-        pos = multPosByParentMatrix(getPos(i), pMatrixCache[i]);
-        drawUtils::drawPoint(pos, GlobalSettings::frameSize);
-        view.popName();
-    }
-
-}
-
-void MotionPath::getFramePositions(std::vector<std::pair<int, MVector>> &vec)
-{
-	for (double i = displayStartTime; i <= displayEndTime; i += 1.0)
-	{
-		ensureParentAndPivotMatrixAtTime(i);
-		vec.push_back(std::pair<int, MVector>(i, multPosByParentMatrix(getPos(i), pMatrixCache[i])));
-	}
-}
-
-void MotionPath::drawCurvesForSelection(M3dView &view, CameraCache* cachePtr)
-{
-    MMatrix currentCameraMatrix;
-    if (GlobalSettings::motionPathDrawMode == GlobalSettings::kCameraSpace)
-    {
-        double currentTime = MAnimControl::currentTime().as(MTime::uiUnit());
-        currentCameraMatrix = cachePtr->matrixCache[currentTime].inverse();
-    }
-    
-    drawPath(view, cachePtr, currentCameraMatrix, true);
+    return getSampleAtTime(time).worldPosition;
 }
 
 int MotionPath::getMinTime(MFnAnimCurve &curveX, MFnAnimCurve &curveY, MFnAnimCurve &curveZ)
@@ -1444,18 +2031,14 @@ BufferPath MotionPath::createBufferPath()
     {
         frames.reserve(int(GlobalSettings::endTime - GlobalSettings::startTime) + 1);
         for (double i = GlobalSettings::startTime; i <= GlobalSettings::endTime; ++i)
-        {
-            ensureParentAndPivotMatrixAtTime(i);
-            frames.push_back(MVector(pMatrixCache[i](3, 0), pMatrixCache[i](3, 1), pMatrixCache[i](3, 2)));
-        }
+            frames.push_back(getSampleAtTime(i).worldPosition);
         
         bp.setMinTime(GlobalSettings::startTime);
     }
     else
     {
         std::map<double, MVector> keyFrames;
-        MStatus xStatus, yStatus, zStatus;
-        MFnAnimCurve curveTX(txPlug, &xStatus), curveTY(tyPlug, &yStatus), curveTZ(tzPlug, &zStatus);
+        MFnAnimCurve curveTX(txPlug), curveTY(tyPlug), curveTZ(tzPlug);
         
         int minTime = getMinTime(curveTX, curveTY, curveTZ);
         int maxTime = getMaxTime(curveTX, curveTY, curveTZ);
@@ -1468,17 +2051,7 @@ BufferPath MotionPath::createBufferPath()
         
         frames.reserve(maxTime - minTime + 1);
         for (double i = minTime; i <= maxTime; ++i)
-        {
-            ensureParentAndPivotMatrixAtTime(i);
-            MTime mtime(i, MTime::uiUnit());
-            
-            float x = xStatus == MS::kNotFound ? txPlug.asDouble() :curveTX.evaluate(mtime);
-            float y = yStatus == MS::kNotFound ? tyPlug.asDouble() :curveTY.evaluate(mtime);
-            float z = zStatus == MS::kNotFound ? tzPlug.asDouble() :curveTZ.evaluate(mtime);
-            
-            MVector vec(x, y, z);
-            frames.push_back(multPosByParentMatrix(vec, pMatrixCache[i]));
-        }
+            frames.push_back(getSampleAtTime(i).worldPosition);
         
         // parse each curve and add keyframes
         keyFrames.clear();
@@ -1489,8 +2062,7 @@ BufferPath MotionPath::createBufferPath()
         for(BPKeyframeIterator keyIt = keyFrames.begin(); keyIt != keyFrames.end(); ++keyIt)
         {
             double time = keyIt->first;
-            ensureParentAndPivotMatrixAtTime(time);
-            keyIt->second = multPosByParentMatrix(getPos(time), pMatrixCache[time]);
+            keyIt->second = getSampleAtTime(time).worldPosition;
         }
         
         bp.setKeyFrames(keyFrames);
@@ -1813,8 +2385,9 @@ void MotionPath::storeSelectedKeysInClipboard()
             curveY.setIsWeighted(true);
             MVector inTangent = evaluateTangentForClipboard(curveX, curveY, curveZ, xKeyID, yKeyID, zKeyID, true);
             MVector outTangent = evaluateTangentForClipboard(curveX, curveY, curveZ, xKeyID, yKeyID, zKeyID, false);
-            kc->inWeightedWorldTangent = multPosByParentMatrix(-inTangent + key->position, pMatrixCache[key->time]);
-            kc->outWeightedWorldTangent = multPosByParentMatrix(outTangent + key->position, pMatrixCache[key->time]);
+            const MMatrix keyPMatrix = ensureParentAndPivotMatrixAtTime(key->time);
+            kc->inWeightedWorldTangent = multPosByParentMatrix(-inTangent + key->position, keyPMatrix);
+            kc->outWeightedWorldTangent = multPosByParentMatrix(outTangent + key->position, keyPMatrix);
             
             //storing the non weighted tangent
             curveX.setIsWeighted(false);
@@ -1822,8 +2395,8 @@ void MotionPath::storeSelectedKeysInClipboard()
             curveY.setIsWeighted(false);
             inTangent = evaluateTangentForClipboard(curveX, curveY, curveZ, xKeyID, yKeyID, zKeyID, true);
             outTangent = evaluateTangentForClipboard(curveX, curveY, curveZ, xKeyID, yKeyID, zKeyID, false);
-            kc->inWorldTangent = multPosByParentMatrix(-inTangent + key->position, pMatrixCache[key->time]);
-            kc->outWorldTangent = multPosByParentMatrix(outTangent + key->position, pMatrixCache[key->time]);
+            kc->inWorldTangent = multPosByParentMatrix(-inTangent + key->position, keyPMatrix);
+            kc->outWorldTangent = multPosByParentMatrix(outTangent + key->position, keyPMatrix);
             
             //setting back the curves to their original states and restoring their values in case they are weighted
             curveX.setIsWeighted(clipboard.isXWeighed());
@@ -1872,12 +2445,14 @@ bool breakTangentsForKeyCopy(const MFnAnimCurve &curve, const double time, const
 
 void MotionPath::pasteKeys(const double time, const bool offset)
 {
+    keyframesDirty = true;
+    
     KeyClipboard &clipboard = KeyClipboard::getClipboard();
     int size = clipboard.getSize();
     
     MVector offsetVec(0,0,0);
     if (offset)
-        offsetVec = multPosByParentMatrix(getPos(time), pMatrixCache[time]);
+        offsetVec = getSampleAtTime(time).worldPosition;
     
     MStatus status;
     MFnAnimCurve curveX(txPlug, &status);
@@ -1923,7 +2498,6 @@ void MotionPath::pasteKeys(const double time, const bool offset)
         if (kc == NULL) continue;
         
         double t = time + kc->deltaTime;
-        ensureParentAndPivotMatrixAtTime(t);
         MTime mtime(t, MTime::uiUnit());
 
         MVector pos = kc->worldPos;
@@ -1935,7 +2509,7 @@ void MotionPath::pasteKeys(const double time, const bool offset)
                 pos = offsetVec + kc->worldPos - clipboard.keyCopyAt(0)->worldPos;
         }
         
-        pos = multPosByParentMatrix(pos, pMatrixCache[t].inverse());
+        pos = multPosByParentMatrix(pos, ensureParentAndPivotMatrixAtTime(t).inverse());
         bool boundaryKey = i == 0 || i == size - 1;
         
         kc->addKeyFrame(curveX, curveY, curveZ, mtime, pos, boundaryKey, mpManager.getAnimCurveChangePtr());
@@ -1960,7 +2534,7 @@ void MotionPath::pasteKeys(const double time, const bool offset)
         bool breakTangentsZ = breakTangentsForKeyCopy(curveZ, t, i == size - 1);
         
         //break tangents at boundaries only if there are keyframes before/after these
-        kc->setTangents(curveX, curveY, curveZ, pMatrixCache[t].inverse(), mtime, boundaryKey, modifyInTangent, modifyOutTangent, breakTangentsX, breakTangentsY, breakTangentsZ, clipboard.isXWeighed(), clipboard.isYWeighed(), clipboard.isZWeighed(), mpManager.getAnimCurveChangePtr());
+        kc->setTangents(curveX, curveY, curveZ, ensureParentAndPivotMatrixAtTime(t).inverse(), mtime, boundaryKey, modifyInTangent, modifyOutTangent, breakTangentsX, breakTangentsY, breakTangentsZ, clipboard.isXWeighed(), clipboard.isYWeighed(), clipboard.isZWeighed(), mpManager.getAnimCurveChangePtr());
     }
     
     mpManager.stopDGAndAnimUndoRecording();
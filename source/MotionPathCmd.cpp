@@ -88,6 +88,14 @@ MSyntax MotionPathCmd::syntaxCreator()
     syntax.addFlag("-dti", "-drawTimeInterval", MSyntax::kDouble);
     syntax.addFlag("-fi", "-frameInterval", MSyntax::kLong);
     syntax.addFlag("-sm", "-strokeMode", MSyntax::kLong);
+    syntax.addFlag("-cfb", "-cacheFillBudget", MSyntax::kLong);
+    syntax.addFlag("-pff", "-prefetchFrames", MSyntax::kLong);
+    syntax.addFlag("-sth", "-samplingThreads", MSyntax::kLong);
+    syntax.addFlag("-pg", "-persistentGeometry", MSyntax::kBoolean);
+    syntax.addFlag("-stl", "-simplifyTolerance", MSyntax::kDouble);
+    syntax.addFlag("-lb", "-labelBudget", MSyntax::kLong);
+    syntax.addFlag("-dtb", "-drawTimeBudget", MSyntax::kDouble);
+    syntax.addFlag("-gql", "-getQualityLevel", MSyntax::kNoArg);
     
     syntax.addFlag("-sdc", "-storeDGAndCurveChange", MSyntax::kNoArg);
     
@@ -106,10 +114,26 @@ MSyntax MotionPathCmd::syntaxCreator()
 	return syntax;
 }
 
+// queries and the flags tuning the tools or the sampling leave the drawn paths as they are
+static bool changesPaths(const MArgDatabase &argData)
+{
+    const char *flags[] = {"-getCurrentSL", "-getQualityLevel", "-storeDGAndCurveChange", "-drawTimeInterval", "-strokeMode",
+                           "-cacheFillBudget", "-prefetchFrames", "-samplingThreads", "-lockedModeInteractive"};
+    for (unsigned int i = 0; i < sizeof(flags) / sizeof(flags[0]); ++i)
+    {
+        if (argData.isFlagSet(flags[i]))
+            return false;
+    }
+    return true;
+}
+
 MStatus MotionPathCmd::doIt(const MArgList& args)
 {
     MArgDatabase argData(syntax(), args);
     
+    if (changesPaths(argData))
+        mpManager.invalidateEvaluation();
+    
 	if(argData.isFlagSet("-enable"))
 	{
 		bool enable;
@@ -240,6 +264,77 @@ MStatus MotionPathCmd::doIt(const MArgList& args)
         argData.getFlagArgument("-strokeMode", 0, strokeMode);
         GlobalSettings::strokeMode = strokeMode;
     }
+    else if (argData.isFlagSet("-cacheFillBudget"))
+    {
+        int cacheFillBudget;
+        argData.getFlagArgument("-cacheFillBudget", 0, cacheFillBudget);
+        
+        if (cacheFillBudget < 1000)
+            cacheFillBudget = 1000;
+        
+        GlobalSettings::cacheFillBudget = cacheFillBudget;
+    }
+    else if (argData.isFlagSet("-prefetchFrames"))
+    {
+        int prefetchFrames;
+        argData.getFlagArgument("-prefetchFrames", 0, prefetchFrames);
+        
+        if (prefetchFrames < 0)
+            prefetchFrames = 0;
+        
+        GlobalSettings::prefetchFrames = prefetchFrames;
+    }
+    else if (argData.isFlagSet("-samplingThreads"))
+    {
+        int samplingThreads;
+        argData.getFlagArgument("-samplingThreads", 0, samplingThreads);
+        
+        if (samplingThreads < 0)
+            samplingThreads = 0;
+        
+        GlobalSettings::samplingThreads = samplingThreads;
+    }
+    else if (argData.isFlagSet("-persistentGeometry"))
+    {
+        bool persistentGeometry;
+        argData.getFlagArgument("-persistentGeometry", 0, persistentGeometry);
+        mpManager.setPersistentGeometry(persistentGeometry);
+    }
+    else if (argData.isFlagSet("-simplifyTolerance"))
+    {
+        double simplifyTolerance;
+        argData.getFlagArgument("-simplifyTolerance", 0, simplifyTolerance);
+        
+        if (simplifyTolerance < 0)
+            simplifyTolerance = 0;
+        
+        GlobalSettings::simplifyTolerance = simplifyTolerance;
+    }
+    else if (argData.isFlagSet("-labelBudget"))
+    {
+        int labelBudget;
+        argData.getFlagArgument("-labelBudget", 0, labelBudget);
+        
+        if (labelBudget < 0)
+            labelBudget = 0;
+        
+        GlobalSettings::labelBudget = labelBudget;
+    }
+    else if (argData.isFlagSet("-drawTimeBudget"))
+    {
+        double drawTimeBudget;
+        argData.getFlagArgument("-drawTimeBudget", 0, drawTimeBudget);
+        
+        if (drawTimeBudget < 0)
+            drawTimeBudget = 0;
+        
+        GlobalSettings::drawTimeBudget = drawTimeBudget;
+    }
+    else if (argData.isFlagSet("-getQualityLevel"))
+    {
+        //0 is full detail, then no labels, no tangents, sparse frames and simplified path
+        this->setResult(static_cast<int>(mpManager.getGovernorLevel()));
+    }
     else if (argData.isFlagSet("-drawMode"))
     {
         int drawMode;
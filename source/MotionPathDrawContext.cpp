@@ -138,11 +138,7 @@ bool MotionPathDrawContext::doPressCommon(MEvent &event, const bool old)
 
     
 	CameraCache * cachePtr = mpManager.MotionPathManager::getCameraCachePtrFromView(activeView);
-	int selectedCurveId;
-	if (!old)
-		selectedCurveId = contextUtils::processCurveHits(initialX, initialY, GlobalSettings::cameraMatrix, activeView, cachePtr, mpManager);
-	else
-		selectedCurveId = contextUtils::processCurveHits(activeView, cachePtr, mpManager);
+	int selectedCurveId = contextUtils::processCurveHits(initialX, initialY, GlobalSettings::cameraMatrix, activeView, cachePtr, mpManager);
 
     if (selectedCurveId != -1)
     {
@@ -152,10 +148,7 @@ bool MotionPathDrawContext::doPressCommon(MEvent &event, const bool old)
             selectedMotionPathPtr->setSelectedFromTool(true);
                 
             MIntArray ids;
-			if (!old)
-				contextUtils::processKeyFrameHits(initialX, initialY, selectedMotionPathPtr, activeView, GlobalSettings::cameraMatrix, cachePtr, ids);
-			else
-				contextUtils::processKeyFrameHits(selectedMotionPathPtr, activeView, cachePtr, ids);
+			contextUtils::processKeyFrameHits(initialX, initialY, selectedMotionPathPtr, activeView, GlobalSettings::cameraMatrix, cachePtr, ids);
             if (ids.length() > 0)
             {
                 selectedKeyId = ids[ids.length() - 1];
@@ -200,6 +193,10 @@ bool MotionPathDrawContext::doPressCommon(MEvent &event, const bool old)
                         
                     selectedMotionPathPtr->addKeyFrameAtTime(selectedTime, mpManager.getAnimCurveChangePtr(), &position);
 
+                    drawnKeys.clear();
+                    strokePoints.clear();
+                    strokePoints.append(MVector(initialX, initialY, 0));
+                    
                     initialClock = clock();
                 }
                     
@@ -268,12 +265,14 @@ bool MotionPathDrawContext::doDragCommon(MEvent &event, const bool old)
                     newPosition = worldPos;
                 }
                 
-                selectedMotionPathPtr->addKeyFrameAtTime(steppedTime, mpManager.getAnimCurveChangePtr(), &newPosition);
-                
-                selectedMotionPathPtr->setEndrawingTime(steppedTime);
+                //keys are only buffered while drawing, the stroke is the preview and they are all written on release
+                drawnKeys.push_back(KeyEdit(KeyEdit::kSet, steppedTime, newPosition));
+                strokePoints.append(MVector(thisX, thisY, 0));
 
                 initialClock = thisClock;
             }
+            
+            return true;
         }
         
         activeView.refresh(false, true);
@@ -306,6 +305,18 @@ MStatus MotionPathDrawContext::doDrag(MEvent &event)
             
             return MStatus::kSuccess;
         }
+        else if (currentMode == kDraw)
+        {
+            activeView.beginXorDrawing(true, true, 2.0f, M3dView::kStippleNone);
+            
+            drawStroke();
+            bool result = doDragCommon(event, true);
+            drawStroke();
+            
+            activeView.endXorDrawing();
+            
+            return result ? MStatus::kSuccess: MStatus::kFailure;
+        }
         else
             return doDragCommon(event, true) ? MStatus::kSuccess: MStatus::kFailure;
     }
@@ -343,6 +354,12 @@ MStatus MotionPathDrawContext::doDrag(MEvent & event, MHWRender::MUIDrawManager&
             
             return MStatus::kSuccess;
         }
+        else if (currentMode == kDraw)
+        {
+            bool result = doDragCommon(event, false);
+            drawStrokeNew(drawMgr);
+            return result ? MStatus::kSuccess: MStatus::kFailure;
+        }
         else
             return doDragCommon(event, false) ? MStatus::kSuccess: MStatus::kFailure;
     }
@@ -539,8 +556,9 @@ bool MotionPathDrawContext::doReleaseCommon(MEvent &event, const bool old)
                     if (pointSize > 0)
                     {
                         //we delete the key frames so maya will recalculate the tangents when adding the keyframes back
-                        for (int i = cache.size() - 1; i > -1 ; --i)
-                            selectedMotionPathPtr->deleteKeyFrameAtTime(cache[i].time, mpManager.getAnimCurveChangePtr(), false);
+                        std::vector<KeyEdit> edits;
+                        for (int i = 0; i < pointSize; ++i)
+                            edits.push_back(KeyEdit(KeyEdit::kDelete, cache[i].time));
                         
                         //get the stroke lenght
                         double strokeLenght = 0;
@@ -570,12 +588,21 @@ bool MotionPathDrawContext::doReleaseCommon(MEvent &event, const bool old)
                                 newPosition = worldPos;
                             }
                             
-                            selectedMotionPathPtr->addKeyFrameAtTime(cache[i].time, mpManager.getAnimCurveChangePtr(), &newPosition, false);
+                            edits.push_back(KeyEdit(KeyEdit::kSet, cache[i].time, newPosition));
                         }
+                        
+                        selectedMotionPathPtr->applyKeyEdits(edits, mpManager.getAnimCurveChangePtr());
                     }
                 }
             }
         }
+        else if (currentMode == kDraw)
+        {
+            //everything drawn goes in with one write per curve, in the same undo as the press
+            selectedMotionPathPtr->applyKeyEdits(drawnKeys, mpManager.getAnimCurveChangePtr());
+            drawnKeys.clear();
+            strokePoints.clear();
+        }
         
         if (currentMode != kNoneMode)
             mpManager.stopDGAndAnimUndoRecording();
@@ -126,11 +126,7 @@ bool MotionPathEditContext::doPressCommon(MEvent &event, const bool old)
     
     CameraCache * cachePtr = mpManager.MotionPathManager::getCameraCachePtrFromView(activeView);
     
-	int selectedCurveId;
-	if (!old)
-		selectedCurveId = contextUtils::processCurveHits(initialX, initialY, GlobalSettings::cameraMatrix, activeView, cachePtr, mpManager);
-	else
-		selectedCurveId = contextUtils::processCurveHits(activeView, cachePtr, mpManager);
+	int selectedCurveId = contextUtils::processCurveHits(initialX, initialY, GlobalSettings::cameraMatrix, activeView, cachePtr, mpManager);
 
     if (selectedCurveId != -1)
     {
@@ -150,10 +146,7 @@ bool MotionPathEditContext::doPressCommon(MEvent &event, const bool old)
             
             MIntArray selectedKeys;
 
-			if (!old)
-				contextUtils::processKeyFrameHits(initialX, initialY, selectedMotionPathPtr, activeView, GlobalSettings::cameraMatrix, cachePtr, selectedKeys);
-			else
-				contextUtils::processKeyFrameHits(selectedMotionPathPtr, activeView, cachePtr, selectedKeys);
+			contextUtils::processKeyFrameHits(initialX, initialY, selectedMotionPathPtr, activeView, GlobalSettings::cameraMatrix, cachePtr, selectedKeys);
 
             if (selectedKeys.length() == 0)
             {
@@ -162,10 +155,7 @@ bool MotionPathEditContext::doPressCommon(MEvent &event, const bool old)
                 {
                     int selectedKeyId;
 
-					if (!old)
-						contextUtils::processTangentHits(initialX, initialY, selectedMotionPathPtr, activeView, GlobalSettings::cameraMatrix, cachePtr, selectedKeyId, selectedTangent);
-					else
-						contextUtils::processTangentHits(selectedMotionPathPtr, activeView, cachePtr, selectedKeyId, selectedTangent);
+					contextUtils::processTangentHits(initialX, initialY, selectedMotionPathPtr, activeView, GlobalSettings::cameraMatrix, cachePtr, selectedKeyId, selectedTangent);
 
                     //move tangent
                     if (selectedTangent != -1)
@@ -277,7 +267,16 @@ void MotionPathEditContext::doDragCommon(MEvent &event, const bool old)
             {
                 MDoubleArray selectedTimes = motionPath->getSelectedKeys();
                 for (int j = 0; j < selectedTimes.length(); j++)
-                    motionPath->offsetWorldPosition(GlobalSettings::motionPathDrawMode == GlobalSettings::kWorldSpace ? offset : offset * cachePtr->matrixCache[selectedTimes[j]].inverse(), selectedTimes[j], mpManager.getAnimCurveChangePtr());
+                {
+                    MVector keyOffset = GlobalSettings::motionPathDrawMode == GlobalSettings::kWorldSpace ? offset : offset * cachePtr->matrixCache[selectedTimes[j]].inverse();
+                    
+                    //the curves are only written on release when the path can preview the move itself
+                    if (!motionPath->previewOffsetWorldPosition(keyOffset, selectedTimes[j]))
+                        motionPath->offsetWorldPosition(keyOffset, selectedTimes[j], mpManager.getAnimCurveChangePtr());
+                }
+                
+                //the samples follow all the keys of the path at once
+                motionPath->refreshPreviewSamples();
             }
         }
         
@@ -352,7 +351,17 @@ void MotionPathEditContext::doReleaseCommon(MEvent &event, const bool old)
     if (selectedMotionPathPtr)
     {
         if(startedRecording && (currentMode == kFrameEditMode || currentMode == kTangentEditMode || currentMode == kShiftKeyMode))
+        {
+            //the previewed key moves go in the same change as everything else, so the drag is a single undo
+            for (int i = 0; i < mpManager.getMotionPathsCount(); i++)
+            {
+                MotionPath *motionPath = mpManager.getMotionPathPtr(i);
+                if (motionPath)
+                    motionPath->commitPreviewOffsets(mpManager.getAnimCurveChangePtr());
+            }
+            
             mpManager.stopDGAndAnimUndoRecording();
+        }
         
         selectedMotionPathPtr->setSelectedFromTool(false);
         selectedMotionPathPtr = NULL;
@@ -48,15 +48,9 @@ void ContextMenuWidget::refreshSelection(const QPoint point)
 	QPoint p = view.widget()->mapFromGlobal(point);
 	double y = view.widget()->height() - p.y() - 1;
 
-	MString name = view.rendererString();
-	bool new_ = name != "hwRender_OpenGL_Renderer" && name != "base_OpenGL_Renderer";
-    
     CameraCache *cachePtr = mpManager.getCameraCachePtrFromView(view);
     
-	if (new_)
-		selectedCurveId = contextUtils::processCurveHits(p.x(), y, GlobalSettings::cameraMatrix, view, cachePtr, mpManager);
-	else
-		selectedCurveId = contextUtils::processCurveHits(view, cachePtr, mpManager);
+	selectedCurveId = contextUtils::processCurveHits(p.x(), y, GlobalSettings::cameraMatrix, view, cachePtr, mpManager);
     if (selectedCurveId == -1)
         return;
     
@@ -65,20 +59,14 @@ void ContextMenuWidget::refreshSelection(const QPoint point)
 	if (!motionPathPtr)
 		return;
 
-	if (new_)
-		contextUtils::processKeyFrameHits(p.x(), y, motionPathPtr, view, GlobalSettings::cameraMatrix, cachePtr, selectedKeys);
-	else
-		contextUtils::processKeyFrameHits(motionPathPtr, view, cachePtr, selectedKeys);
+	contextUtils::processKeyFrameHits(p.x(), y, motionPathPtr, view, GlobalSettings::cameraMatrix, cachePtr, selectedKeys);
     if (selectedKeys.length() > 0)
     {
         keyframe = true;
         return;
     }
     
-	if (new_)
-		frame = contextUtils::processFramesHits(p.x(), y, motionPathPtr, view, GlobalSettings::cameraMatrix, cachePtr, frameTime);
-	else
-		frame = contextUtils::processFramesHits(motionPathPtr, view, cachePtr, frameTime);
+	frame = contextUtils::processFramesHits(p.x(), y, motionPathPtr, view, GlobalSettings::cameraMatrix, cachePtr, frameTime);
 
 }
 
@@ -217,8 +205,10 @@ void ContextMenuWidget::menuAction(QAction *action)
         
         MDoubleArray sk = motionPathPtr->getSelectedKeys();
         motionPathPtr->deselectAllKeys();
-        for (int i = sk.length() - 1; i > -1 ; --i)
-            motionPathPtr->deleteKeyFrameAtTime(sk[i], mpManager.getAnimCurveChangePtr());
+        std::vector<KeyEdit> edits;
+        for (int i = 0; i < sk.length(); ++i)
+            edits.push_back(KeyEdit(KeyEdit::kDelete, sk[i]));
+        motionPathPtr->applyKeyEdits(edits, mpManager.getAnimCurveChangePtr());
         
         mpManager.stopDGAndAnimUndoRecording();
         M3dView::active3dView().refresh();
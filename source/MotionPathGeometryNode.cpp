@@ -0,0 +1,42 @@
+//
+//  MotionPathGeometryNode.cpp
+//  MotionPath
+//
+//
+
+#include "MotionPathGeometryNode.h"
+
+// the default is in the 0x00000 - 0x7ffff range Autodesk keeps for nodes that never leave the studio,
+// builds that get distributed have to set it to an id of the vendor's block (see GEOMETRY_NODE_ID in the Makefile)
+#ifndef MOTIONPATH_GEOMETRY_NODE_ID
+#define MOTIONPATH_GEOMETRY_NODE_ID 0x0007ff00
+#endif
+
+MTypeId MotionPathGeometryNode::id(MOTIONPATH_GEOMETRY_NODE_ID);
+MString MotionPathGeometryNode::typeName("tcMotionPathGeometry");
+MString MotionPathGeometryNode::drawDbClassification("drawdb/subscene/tcMotionPathGeometry");
+MString MotionPathGeometryNode::drawRegistrantId("tcMotionPathGeometryPlugin");
+
+MotionPathGeometryNode::MotionPathGeometryNode()
+{
+}
+
+MotionPathGeometryNode::~MotionPathGeometryNode()
+{
+}
+
+bool MotionPathGeometryNode::isBounded() const
+{
+    //the paths can be anywhere, the render items carry their own bounds
+    return false;
+}
+
+void* MotionPathGeometryNode::creator()
+{
+    return new MotionPathGeometryNode();
+}
+
+MStatus MotionPathGeometryNode::initialize()
+{
+    return MStatus::kSuccess;
+}
@@ -15,12 +15,33 @@
 #include <maya/MDrawContext.h>
 
 #include "MotionPathManager.h"
+#include "MotionPathGeometryNode.h"
 #include "GlobalSettings.h"
 
+#include <algorithm>
+
+// frames evaluated by a single worker task when sampling paths in parallel
+static const int kSampleChunkSize = 64;
+
 MotionPathManager::MotionPathManager()
 {
     animCurveChangePtr = NULL;
     cacheDone = true;
+    cacheFillCallbackId = 0;
+    cacheFillCenter = 0;
+    cacheFillExpansion = 0;
+    
+    lastPlayheadFrame = 0;
+    playheadVelocity = 0;
+    prefetchDirection = 0;
+    prefetchLookahead = 0;
+    prefetchOffset = 0;
+    
+    sceneVersion = 0;
+    evaluationValid = false;
+    evaluatedSceneVersion = 0;
+    evaluatedTime = 0;
+    drawLevel = DrawGovernor::kFull;
 
     pathArray.clear();
     selectionObjects.clear();
@@ -72,6 +93,7 @@ void MotionPathManager::setupViewport(const MString &panelName)
     
     RegisteredPanel rp;
     rp.name = panelName;
+    rp.widget = status ? view.widget() : NULL;
     rp.cameraWorldMatrixCallbackId = worldCallbackID;
     rp.cameraNameChangedId = cameraNameChangedId;
     rp.cameraChangedId = cameraChangedId;
@@ -89,6 +111,10 @@ void MotionPathManager::setupViewports()
     for(unsigned int i = 0; i < panelNames.length(); i++)
 		if (panelRegistered(panelNames[i]) == -1)
             setupViewport(panelNames[i]);
+    
+    //the hidden locator only goes in the scene when persistent geometry was asked for
+    if (GlobalSettings::persistentGeometry)
+        createGeometryNode();
 }
 
 /*
@@ -302,8 +328,276 @@ void MotionPathManager::drawBufferPaths(M3dView &view, CameraCache* cachePtr, MH
 
 void MotionPathManager::drawPaths(M3dView view, CameraCache* cachePtr, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
 {
+    //the panel is timed as a whole, the governor lowers its detail when it keeps going over budget.
+    //The evaluation in preparePaths is shared by every panel and does not depend on the level, so it is not counted
+    const void *panel = view.widget();
+    drawLevel = drawGovernor.getPanelLevel(panel);
+    
+    preparePaths(cachePtr);
+    
+    std::chrono::steady_clock::time_point drawStart = std::chrono::steady_clock::now();
+    
+    labelPlacer.begin(view.portWidth(), view.portHeight());
+    
+    //the pick index of the panel is refreshed with every draw, clicks then only query it
+    PickIndex &pickIndex = pickIndices[panel];
+    pickIndex.begin(view.portWidth(), view.portHeight());
+    
 	for (int i = 0; i < pathArray.size(); ++i)
+    {
 		pathArray[i].draw(view, cachePtr, drawManager, frameContext);
+        pathArray[i].addPickItems(pickIndex, i, cachePtr, GlobalSettings::screenProjector);
+    }
+    
+    pickIndex.build();
+    
+    //labels of all the paths compete for the same screen space, so they are only drawn now
+    labelPlacer.draw(GlobalSettings::screenProjector, view, GlobalSettings::cameraMatrix, drawManager);
+    
+    drawGovernor.reportPanelTime(panel, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - drawStart).count());
+    drawLevel = DrawGovernor::kFull;
+}
+
+const PickIndex* MotionPathManager::getPickIndex(M3dView &view)
+{
+    std::map<const void*, PickIndex>::const_iterator it = pickIndices.find(view.widget());
+    if (it == pickIndices.end() || !it->second.isBuilt())
+        return NULL;
+    return &it->second;
+}
+
+int MotionPathManager::getMotionPathIndex(const MotionPath *motionPathPtr)
+{
+    for (int i = 0; i < pathArray.size(); ++i)
+        if (&pathArray[i] == motionPathPtr)
+            return i;
+    return -1;
+}
+
+bool MotionPathManager::persistentGeometryActive()
+{
+    return GlobalSettings::persistentGeometry && GlobalSettings::motionPathDrawMode == GlobalSettings::kWorldSpace && geometryNode.isValid();
+}
+
+void MotionPathManager::getPathGeometry(std::vector<PathGeometry> &geometry, std::vector<unsigned int> &stamps, std::vector<unsigned char> &changed)
+{
+    preparePaths(NULL);
+    
+    //the buffers are shared by every panel, they follow the one the governor had to lower the most
+    drawLevel = drawGovernor.getLevel();
+    
+    unsigned int sceneStamp = getGeometryStamp();
+    geometry.resize(pathArray.size());
+    stamps.resize(pathArray.size(), 0);
+    changed.assign(pathArray.size(), 0);
+    for (int i = 0; i < pathArray.size(); ++i)
+    {
+        unsigned int stamp = pathArray[i].getGeometryStamp(sceneStamp);
+        if (stamp == stamps[i] && stamp != 0)
+            continue;
+        
+        pathArray[i].fillGeometry(geometry[i]);
+        stamps[i] = stamp;
+        changed[i] = 1;
+    }
+    
+    drawLevel = DrawGovernor::kFull;
+}
+
+bool MotionPathManager::pathGeometryChanged(const std::vector<unsigned int> &stamps)
+{
+    if (!persistentGeometryActive())
+        return !stamps.empty();
+    
+    //paths that have to be sampled again might end up where they were, update tells
+    if (stamps.size() != pathArray.size() || pathsNeedSampling())
+        return true;
+    
+    unsigned int sceneStamp = getGeometryStamp();
+    for (int i = 0; i < pathArray.size(); ++i)
+        if (pathArray[i].getGeometryStamp(sceneStamp) != stamps[i])
+            return true;
+    
+    return false;
+}
+
+unsigned int MotionPathManager::getGeometryStamp()
+{
+    unsigned int stamp = 2166136261u;
+    double currentTime = MAnimControl::currentTime().as(MTime::uiUnit());
+    DrawGovernor::Level level = drawGovernor.getLevel();
+    PathGeometry::addToStamp(stamp, &sceneVersion, sizeof(sceneVersion));
+    PathGeometry::addToStamp(stamp, &currentTime, sizeof(currentTime));
+    PathGeometry::addToStamp(stamp, &level, sizeof(level));
+    
+    PathGeometry::addToStamp(stamp, &GlobalSettings::framesBack, sizeof(double));
+    PathGeometry::addToStamp(stamp, &GlobalSettings::framesFront, sizeof(double));
+    PathGeometry::addToStamp(stamp, &GlobalSettings::pathColor, sizeof(MColor));
+    PathGeometry::addToStamp(stamp, &GlobalSettings::weightedPathColor, sizeof(MColor));
+    PathGeometry::addToStamp(stamp, &GlobalSettings::tangentColor, sizeof(MColor));
+    PathGeometry::addToStamp(stamp, &GlobalSettings::brokenTangentColor, sizeof(MColor));
+    PathGeometry::addToStamp(stamp, &GlobalSettings::weightedPathTangentColor, sizeof(MColor));
+    PathGeometry::addToStamp(stamp, &GlobalSettings::showTangents, sizeof(bool));
+    PathGeometry::addToStamp(stamp, &GlobalSettings::showKeyFrames, sizeof(bool));
+    PathGeometry::addToStamp(stamp, &GlobalSettings::showRotationKeyFrames, sizeof(bool));
+    PathGeometry::addToStamp(stamp, &GlobalSettings::showPath, sizeof(bool));
+    PathGeometry::addToStamp(stamp, &GlobalSettings::alternatingFrames, sizeof(bool));
+    PathGeometry::addToStamp(stamp, &GlobalSettings::usePivots, sizeof(bool));
+    //not read by fillGeometry but by the shaders set up in the same update
+    PathGeometry::addToStamp(stamp, &GlobalSettings::pathSize, sizeof(double));
+    PathGeometry::addToStamp(stamp, &GlobalSettings::frameSize, sizeof(double));
+    return stamp;
+}
+
+bool MotionPathManager::pathsNeedSampling()
+{
+    if (!evaluationValid || evaluatedSceneVersion != sceneVersion || evaluatedTime != MAnimControl::currentTime().as(MTime::uiUnit()))
+        return true;
+    
+    for (int i = 0; i < pathArray.size(); ++i)
+        if (pathArray[i].liveValuesChanged())
+            return true;
+    
+    return false;
+}
+
+void MotionPathManager::preparePaths(CameraCache* cachePtr)
+{
+    //the samples are world space whatever the panel, so they are evaluated once per time and scene version
+    //and every panel drawn in the same refresh, viewport 2.0 buffers included, reuses them
+    if (pathsNeedSampling())
+    {
+        for (int i = 0; i < pathArray.size(); ++i)
+            pathArray[i].beginDraw();
+        
+        cachePathSamples();
+        
+        evaluationValid = true;
+        evaluatedSceneVersion = sceneVersion;
+        evaluatedTime = MAnimControl::currentTime().as(MTime::uiUnit());
+    }
+    
+    //keys are only rebuilt when their curves changed, what's left here is the projection for this panel's camera
+    for (int i = 0; i < pathArray.size(); ++i)
+        pathArray[i].prepareKeyFrames(cachePtr);
+}
+
+void MotionPathManager::setPersistentGeometry(const bool value)
+{
+    GlobalSettings::persistentGeometry = value;
+    
+    //while the tool is off the node is created by setupViewports when enabling it
+    if (!GlobalSettings::enabled)
+        return;
+    
+    if (value)
+        createGeometryNode();
+    else
+        deleteGeometryNode();
+}
+
+void MotionPathManager::createGeometryNode()
+{
+    if (geometryNode.isValid())
+        return;
+    
+    //createNode gives back the transform above the locator, that's what we hide and later delete
+    MDagModifier dagModifier;
+    MObject transform = dagModifier.createNode(MotionPathGeometryNode::typeName);
+    if (transform.isNull() || !dagModifier.doIt())
+        return;
+    
+    //never saved with the scene and kept out of the outliner
+    MFnDagNode transformFn(transform);
+    transformFn.setDoNotWrite(true);
+    for (unsigned int i = 0; i < transformFn.childCount(); ++i)
+        MFnDependencyNode(transformFn.child(i)).setDoNotWrite(true);
+    
+    MPlug hiddenPlug = transformFn.findPlug("hiddenInOutliner");
+    if (!hiddenPlug.isNull())
+        hiddenPlug.setValue(true);
+    
+    geometryNode = MObjectHandle(transform);
+}
+
+void MotionPathManager::deleteGeometryNode()
+{
+    //the node is gone already after a new scene
+    if (geometryNode.isValid())
+    {
+        MDagModifier dagModifier;
+        dagModifier.deleteNode(geometryNode.object());
+        dagModifier.doIt();
+    }
+    
+    geometryNode = MObjectHandle();
+    evaluationValid = false;
+}
+
+void MotionPathManager::cachePathSamples()
+{
+    if (pathArray.size() == 0)
+        return;
+    
+    // paths that could be snapshotted are pure math, they are split in chunks of frames and spread across the pool
+    std::vector<unsigned char> nativePaths(pathArray.size(), 0);
+    std::vector<std::vector<PathSample> > nativeSamples(pathArray.size());
+    std::vector<std::vector<unsigned char> > nativeNewMatrix(pathArray.size());
+    std::vector<WorkerPool::Task> tasks;
+    for (int i = 0; i < pathArray.size(); ++i)
+    {
+        if (!pathArray[i].hasNativeSamples())
+            continue;
+        
+        nativePaths[i] = 1;
+        int count = pathArray[i].getNativeSampleCount();
+        nativeSamples[i].resize(count);
+        nativeNewMatrix[i].resize(count);
+        
+        const MotionPath *path = &pathArray[i];
+        for (int first = 0; first < count; first += kSampleChunkSize)
+        {
+            int chunk = std::min(kSampleChunkSize, count - first);
+            PathSample *samples = &nativeSamples[i][first];
+            unsigned char *newMatrix = &nativeNewMatrix[i][first];
+            tasks.push_back([path, first, chunk, samples, newMatrix]() {path->computeNativeSamples(first, chunk, samples, newMatrix);});
+        }
+    }
+    
+    workerPool.setNumThreads(GlobalSettings::samplingThreads);
+    workerPool.run(tasks);
+    
+    // every chunk wrote its own slots, so publishing in path order gives the same caches however the work was split
+    bool dgPaths = false;
+    double startFrame = 0, endFrame = 0;
+    for (int i = 0; i < pathArray.size(); ++i)
+    {
+        if (nativePaths[i])
+        {
+            pathArray[i].publishNativeSamples(nativeSamples[i], nativeNewMatrix[i]);
+            continue;
+        }
+        
+        if (!dgPaths || pathArray[i].getDisplayStartTime() < startFrame) startFrame = pathArray[i].getDisplayStartTime();
+        if (!dgPaths || pathArray[i].getDisplayEndTime() > endFrame) endFrame = pathArray[i].getDisplayEndTime();
+        dgPaths = true;
+    }
+    
+    // one context per frame shared by all the remaining paths, rather than one per path per frame
+    for (double t = startFrame; dgPaths && t <= endFrame; t += 1.0)
+    {
+        MDGContext context(MTime(t, MTime::uiUnit()));
+        for (int i = 0; i < pathArray.size(); ++i)
+        {
+            if (!nativePaths[i] && t >= pathArray[i].getDisplayStartTime() && t <= pathArray[i].getDisplayEndTime())
+                pathArray[i].cacheSampleAtTime(t, context);
+        }
+    }
+    
+    MTime currentTime = MAnimControl::currentTime();
+    MDGContext currentContext(currentTime);
+    for (int i = 0; i < pathArray.size(); ++i)
+        pathArray[i].cacheSampleAtTime(currentTime.as(MTime::uiUnit()), currentContext);
 }
 
 void MotionPathManager::viewPostRenderCallback(const MString& panelName, void* data)
@@ -322,6 +616,7 @@ void MotionPathManager::viewPostRenderCallback(const MString& panelName, void* d
             CameraCache* cachePtr = NULL;
             
             GlobalSettings::cameraMatrix = camera.inclusiveMatrix();
+            GlobalSettings::screenProjector.set(view);
             
             //world space mode
             if (GlobalSettings::motionPathDrawMode == GlobalSettings::kWorldSpace)
@@ -354,8 +649,9 @@ void MotionPathManager::viewPostRenderCallback(const MString& panelName, void* d
 			
 			view.beginGL();
             
-			glPushAttrib(GL_ALL_ATTRIB_BITS);
-            glPushClientAttrib(GL_CLIENT_ALL_ATTRIB_BITS);
+			//only the state our drawing touches: enables, color, line and point sizes, blending and matrix mode
+			glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_LINE_BIT | GL_POINT_BIT | GL_COLOR_BUFFER_BIT | GL_TRANSFORM_BIT);
+            glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
 			glPushMatrix();
             
 			glDisable(GL_LIGHTING);
@@ -364,8 +660,7 @@ void MotionPathManager::viewPostRenderCallback(const MString& panelName, void* d
             for (int i = 0; i < mpManager->bufferPathArray.size(); ++i)
                 mpManager->bufferPathArray[i].draw(view, cachePtr);
             
-			for(int i = 0; i < mpManager->pathArray.size(); ++i)
-                mpManager->pathArray[i].draw(view, cachePtr);
+            mpManager->drawPaths(view, cachePtr);
             
 			glPopMatrix();
 			glPopAttrib();
@@ -386,6 +681,10 @@ void MotionPathManager::viewDestroyCallback(const MString& panelName, void* data
         {
             if (manager->registeredPanels[i].name == panelName)
             {
+                //the widget pointer could be handed to a new panel, nothing of this one can be left behind
+                manager->drawGovernor.removePanel(manager->registeredPanels[i].widget);
+                manager->pickIndices.erase(manager->registeredPanels[i].widget);
+                
                 manager->removePanelCallback(manager->registeredPanels[i]);
                 manager->registeredPanels.erase(manager->registeredPanels.begin() + i);
                 return;
@@ -413,7 +712,13 @@ void MotionPathManager::cleanupViewports()
     for (unsigned int i = 0; i < registeredPanels.size(); ++i)
         removePanelCallback(registeredPanels[i]);
     
+    cancelCacheFill();
+    
+    deleteGeometryNode();
+    
     registeredPanels.clear();
+    drawGovernor.clear();
+    pickIndices.clear();
     pathArray.clear();
     selectionObjects.clear();
     bufferPathArray.clear();
@@ -448,6 +753,21 @@ void MotionPathManager::addCallbacks()
     
     id = MModelMessage::addCallback(MModelMessage::kActiveListModified, selectionChangeCallback, this);
     this->cbIDs.append(id);
+    
+    id = MAnimMessage::addAnimCurveEditedCallback(animCurveEditedCallback, this);
+    this->cbIDs.append(id);
+}
+
+void MotionPathManager::animCurveEditedCallback(MObjectArray &editedCurves, void *data)
+{
+    MotionPathManager* mpManager = (MotionPathManager*) data;
+	if(!mpManager)
+		return;
+    
+    //curves of ancestors move the keys too, so every path rebuilds its keys
+    for (int i = 0; i < mpManager->pathArray.size(); ++i)
+        mpManager->pathArray[i].setKeyframesDirty();
+    mpManager->invalidateEvaluation();
 }
 
 void MotionPathManager::sceneOpenedCallback(void *data)
@@ -476,6 +796,8 @@ void MotionPathManager::removeCallbacks()
     }
     
     this->cbIDs.clear();
+    
+    cancelCacheFill();
 }
 
 void MotionPathManager::getSelection(MObjectArray &objArray)
@@ -560,9 +882,72 @@ void MotionPathManager::timeChangeEvent(MTime &currentTime,  void* data)
 {
     MotionPathManager* mpManager = (MotionPathManager*) data;
 	if(mpManager)
+    {
+        mpManager->updatePlayheadMotion(currentTime.as(MTime::uiUnit()));
 		mpManager->refreshDisplayTimeRange();
+    }
+}
 
+void MotionPathManager::updatePlayheadMotion(const double currentFrame)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double step = currentFrame - lastPlayheadFrame;
+    double seconds = std::chrono::duration<double>(now - lastPlayheadClock).count();
+    
+    lastPlayheadFrame = currentFrame;
+    lastPlayheadClock = now;
+    
+    // a pause or a single time change is not a scrub, we don't know where the user is going next
+    if (step == 0 || seconds > 0.5)
+    {
+        prefetchDirection = 0;
+        playheadVelocity = 0;
+        return;
+    }
+    
+    int direction = step > 0 ? 1 : -1;
+    double velocity = std::fabs(step) / (seconds > 0.001 ? seconds : 0.001);
+    
+    if (direction != prefetchDirection)
+        playheadVelocity = velocity;
+    else
+        playheadVelocity = 0.5 * playheadVelocity + 0.5 * velocity;
+    prefetchDirection = direction;
+    
+    // looking half a second ahead, but never less than a couple of steps
+    prefetchLookahead = playheadVelocity * 0.5;
+    if (prefetchLookahead < std::fabs(step) * 2)
+        prefetchLookahead = std::fabs(step) * 2;
+    if (prefetchLookahead > GlobalSettings::prefetchFrames)
+        prefetchLookahead = GlobalSettings::prefetchFrames;
+    prefetchLookahead = std::ceil(prefetchLookahead);
+    
+    // samples far behind the playhead are not going to be drawn again any time soon
+    double keepStart = currentFrame - GlobalSettings::framesBack - GlobalSettings::prefetchFrames;
+    double keepEnd = currentFrame + GlobalSettings::framesFront + GlobalSettings::prefetchFrames;
+    for(int i = 0; i < pathArray.size(); i++)
+    {
+        if (pathArray[i].evictParentMatrixCache(keepStart, keepEnd))
+            cacheDone = false;
+    }
+}
 
+// echoed commands that can move the animated objects, results, warnings and errors printed in the script editor can't
+static bool isSceneEdit(const MString &message, MCommandMessage::MessageType messageType)
+{
+    if (messageType == MCommandMessage::kResult || messageType == MCommandMessage::kWarning ||
+        messageType == MCommandMessage::kError || messageType == MCommandMessage::kStackTrace)
+        return false;
+    
+    const char *commands[] = {"Undo:", "Redo:", "undo", "redo", "setKeyframe", "cutKey", "pasteKey", "keyframe",
+                              "bakeResults", "setAttr", "move", "rotate", "scale", "xform", "parent", "delete", "file", "connectAttr",
+                              "disconnectAttr", "Constraint", "Driven", "expression", "animLayer"};
+    for (unsigned int i = 0; i < sizeof(commands) / sizeof(commands[0]); ++i)
+    {
+        if (message.indexW(commands[i]) > -1)
+            return true;
+    }
+    return false;
 }
 
 void MotionPathManager::commandEvent(const MString &message, MCommandMessage::MessageType messageType, void *data)
@@ -570,6 +955,10 @@ void MotionPathManager::commandEvent(const MString &message, MCommandMessage::Me
     MotionPathManager* mpManager = (MotionPathManager*) data;
 	if(mpManager)
 	{
+        //undo, redo and scripts can touch the scene without editing curves or moving the objects at the current time
+        if (isSceneEdit(message, messageType))
+            mpManager->invalidateEvaluation();
+        
 		if(message.indexW("setKeyframe") > -1)
 		{
 			// will cause a refresh once maya is done with updating the curves
@@ -591,15 +980,26 @@ void MotionPathManager::refreshDisplayTimeRange()
 {
     double currentFrame = MAnimControl::currentTime().as(MTime::uiUnit());
     
+    invalidateEvaluation();
+    
+    if(!cacheDone)
+    {
+        startCacheFill(currentFrame);
+        // the first slice runs right away so the frames around the current time are there for this refresh
+        fillCacheChunk();
+    }
+    
+    applyDisplayTimeRange(currentFrame);
+}
+
+void MotionPathManager::applyDisplayTimeRange(const double currentFrame)
+{
     double startFrame = currentFrame - GlobalSettings::framesBack;
     double endFrame = currentFrame + GlobalSettings::framesFront;
     
     if(startFrame < GlobalSettings::startTime)	startFrame = GlobalSettings::startTime;
 	if(endFrame > GlobalSettings::endTime) 	endFrame = GlobalSettings::endTime;
     
-    if(!cacheDone)
-		cacheDone = expandParentMatrixAndPivotCache(currentFrame);
-    
 	for(int i = 0; i < pathArray.size(); i++)
 		pathArray[i].setDisplayTimeRange(startFrame, endFrame);
 }
@@ -610,40 +1010,101 @@ void MotionPathManager::clearParentMatrixCaches()
 		pathArray[i].clearParentMatrixCache();
 }
 
-bool MotionPathManager::expandParentMatrixAndPivotCache(const double currentTimeValue)
+void MotionPathManager::startCacheFill(const double currentTimeValue)
 {
-    double timeout = 2.0;
-	time_t startTime = time(NULL);
+    // keep going if we are already filling around this frame
+    if (cacheFillCallbackId != 0 && cacheFillCenter == currentTimeValue)
+        return;
     
-	double nUpdqates = GlobalSettings::framesFront;
-	if(GlobalSettings::framesBack > GlobalSettings::framesFront)
-		nUpdqates = GlobalSettings::framesBack;
+    cacheFillCenter = currentTimeValue;
+    cacheFillExpansion = 0;
+    prefetchOffset = 0;
     
-	bool cacheCompleted = true;
+    if (cacheFillCallbackId == 0)
+    {
+        MStatus status;
+        cacheFillCallbackId = MEventMessage::addEventCallback("idle", cacheFillIdleCallback, this, &status);
+        if (!status)
+            cacheFillCallbackId = 0;
+    }
+}
+
+void MotionPathManager::cancelCacheFill()
+{
+    if (cacheFillCallbackId != 0)
+        MMessage::removeCallback(cacheFillCallbackId);
+    cacheFillCallbackId = 0;
+}
+
+bool MotionPathManager::fillCacheChunk()
+{
+    std::chrono::steady_clock::time_point chunkStart = std::chrono::steady_clock::now();
+    std::chrono::microseconds budget(GlobalSettings::cacheFillBudget);
+    
+	double nUpdates = GlobalSettings::framesFront;
+	if(GlobalSettings::framesBack > GlobalSettings::framesFront)
+		nUpdates = GlobalSettings::framesBack;
     
-	for(double i = 0; i <= nUpdqates; i++)
+    // we grow one frame on each side at a time so the frames closer to the current time are always filled first
+	while(cacheFillExpansion <= nUpdates)
 	{
-		time_t currentTime = time(NULL);
-		double secs = difftime(currentTime, startTime);
-        
-		if(secs < timeout)
+        bool pathsPending = false;
+		for(int j = 0; j < pathArray.size(); j++)
 		{
-			cacheCompleted = true;
-            
-			for(int j = 0; j < pathArray.size(); j++)
+			if(!pathArray[j].isCacheDone())
 			{
-				if(!pathArray[j].isCacheDone())
-				{
-					pathArray[j].growParentAndPivotMatrixCache(currentTimeValue, i);
-					cacheCompleted = false;
-				}
+				pathArray[j].growParentAndPivotMatrixCache(cacheFillCenter, cacheFillExpansion);
+				pathsPending = true;
 			}
 		}
-		else
-			break;
+        
+		cacheFillExpansion += 1;
+        
+        if (!pathsPending)
+            break;
+        
+        if (std::chrono::steady_clock::now() - chunkStart >= budget)
+            return false;
 	}
     
-	return cacheCompleted;
+    // with the window around the current time done we keep evaluating ahead of the playhead
+    while (prefetchDirection != 0 && prefetchOffset < prefetchLookahead)
+    {
+        prefetchOffset += 1;
+        
+        double frame = prefetchDirection > 0 ? cacheFillCenter + GlobalSettings::framesFront + prefetchOffset : cacheFillCenter - GlobalSettings::framesBack - prefetchOffset;
+        for(int j = 0; j < pathArray.size(); j++)
+            pathArray[j].prefetchParentMatrixAtTime(frame);
+        
+        if (std::chrono::steady_clock::now() - chunkStart >= budget)
+            return false;
+    }
+    
+    cancelCacheFill();
+    
+    cacheDone = true;
+    for(int j = 0; j < pathArray.size(); j++)
+        if(!pathArray[j].isCacheDone())
+            cacheDone = false;
+    
+	return true;
+}
+
+void MotionPathManager::cacheFillIdleCallback(void *data)
+{
+    MotionPathManager* mpManager = (MotionPathManager*) data;
+	if(!mpManager)
+		return;
+    
+    double previousExpansion = mpManager->cacheFillExpansion;
+    mpManager->fillCacheChunk();
+    
+    // prefetching does not change what is on screen, we only redraw while the window is growing
+    if (mpManager->cacheFillExpansion != previousExpansion)
+    {
+        mpManager->applyDisplayTimeRange(mpManager->cacheFillCenter);
+        M3dView::active3dView().refresh(true);
+    }
 }
 
 void MotionPathManager::setTimeRange(const double start, const double end)
@@ -654,19 +1115,10 @@ void MotionPathManager::setTimeRange(const double start, const double end)
 	for(int i = 0; i < pathArray.size(); i++)
 		pathArray[i].setTimeRange(GlobalSettings::startTime, GlobalSettings::endTime);
     
+    cancelCacheFill();
 	cacheDone = false;
 }
 
-void MotionPathManager::drawCurvesForSelection(M3dView &view, CameraCache *cachePtr)
-{
-    for(int i = 0; i < pathArray.size(); i++)
-	{
-		view.pushName(i);
-		pathArray[i].drawCurvesForSelection(view, cachePtr);
-		view.popName();
-	}
-}
-
 MotionPath* MotionPathManager::getMotionPathPtr(const int id)
 {
 	if(id >= 0 && id < pathArray.size())
@@ -690,6 +1142,10 @@ void MotionPathManager::setSelectionList(const MObjectArray &list)
     std::vector<MotionPath> oldPathArray = pathArray;
     MObjectArray oldSelectionObjects (selectionObjects);
     
+    invalidateEvaluation();
+    
+    //the indices refer to the old paths
+    pickIndices.clear();
     pathArray.clear();
     selectionObjects.clear();
     
@@ -714,6 +1170,7 @@ void MotionPathManager::setSelectionList(const MObjectArray &list)
         }
     }
     
+    cancelCacheFill();
     cacheDone = false;
 }
 
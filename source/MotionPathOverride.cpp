@@ -81,6 +81,7 @@ void MotionPathUserOperation::addUIDrawables(
 		CameraCache* cachePtr = NULL;
 
 		GlobalSettings::cameraMatrix = camera.inclusiveMatrix();
+		GlobalSettings::screenProjector.set(frameContext);
 
 		//world space mode
 		if (GlobalSettings::motionPathDrawMode == GlobalSettings::kWorldSpace)
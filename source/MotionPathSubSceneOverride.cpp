@@ -0,0 +1,303 @@
+//
+//  MotionPathSubSceneOverride.cpp
+//  MotionPath
+//
+//
+
+#include "MotionPathSubSceneOverride.h"
+#include "MotionPathManager.h"
+#include "GlobalSettings.h"
+
+#include <maya/MBoundingBox.h>
+#include <maya/MPoint.h>
+#include <maya/MDrawContext.h>
+#include <maya/MStateManager.h>
+
+#include <cstring>
+
+extern MotionPathManager mpManager;
+
+//the paths are drawn through the geometry like the legacy draw does with beginDrawInXray,
+//the shaders turn the depth test off right before their items are drawn and back on after
+static const MHWRender::MDepthStencilState *xrayState = NULL;
+static const MHWRender::MDepthStencilState *previousState = NULL;
+
+static void beginXray(MHWRender::MDrawContext &context, const MHWRender::MRenderItemList &renderItemList, MHWRender::MShaderInstance *shaderInstance)
+{
+    MHWRender::MStateManager *stateManager = context.getStateManager();
+    if (!stateManager || !xrayState)
+        return;
+
+    previousState = stateManager->getDepthStencilState();
+    stateManager->setDepthStencilState(xrayState);
+}
+
+static void endXray(MHWRender::MDrawContext &context, const MHWRender::MRenderItemList &renderItemList, MHWRender::MShaderInstance *shaderInstance)
+{
+    MHWRender::MStateManager *stateManager = context.getStateManager();
+    if (!stateManager || !previousState)
+        return;
+
+    stateManager->setDepthStencilState(previousState);
+    previousState = NULL;
+}
+
+MHWRender::MPxSubSceneOverride* MotionPathSubSceneOverride::creator(const MObject &obj)
+{
+    return new MotionPathSubSceneOverride(obj);
+}
+
+MotionPathSubSceneOverride::MotionPathSubSceneOverride(const MObject &obj):
+    MHWRender::MPxSubSceneOverride(obj)
+{
+    for (int i = 0; i < PathGeometry::kNumItems; ++i)
+        shaders[i] = NULL;
+    numPaths = 0;
+}
+
+MotionPathSubSceneOverride::~MotionPathSubSceneOverride()
+{
+    for (std::map<std::string, ItemBuffers>::iterator it = itemBuffers.begin(); it != itemBuffers.end(); ++it)
+        releaseBuffers(it->second);
+    itemBuffers.clear();
+
+    releaseShaders();
+}
+
+MHWRender::DrawAPI MotionPathSubSceneOverride::supportedDrawAPIs() const
+{
+    return MHWRender::kAllDevices;
+}
+
+bool MotionPathSubSceneOverride::requiresUpdate(const MHWRender::MSubSceneContainer &container, const MHWRender::MFrameContext &frameContext) const
+{
+    //camera moves and refreshes that did not touch the scene, the time or the settings keep the buffers as they are
+    return mpManager.pathGeometryChanged(stamps);
+}
+
+void MotionPathSubSceneOverride::update(MHWRender::MSubSceneContainer &container, const MHWRender::MFrameContext &frameContext)
+{
+    int pathCount = 0;
+    if (mpManager.persistentGeometryActive() && ensureShaders())
+    {
+        float pathWidth[2] = {static_cast<float>(GlobalSettings::pathSize), static_cast<float>(GlobalSettings::pathSize)};
+        float frameSize[2] = {static_cast<float>(GlobalSettings::pathSize * 2), static_cast<float>(GlobalSettings::pathSize * 2)};
+        float tangentWidth[2] = {1.0f, 1.0f};
+        float handleSize[2] = {static_cast<float>(GlobalSettings::frameSize), static_cast<float>(GlobalSettings::frameSize)};
+        shaders[PathGeometry::kPath]->setParameter("lineWidth", pathWidth);
+        shaders[PathGeometry::kFrames]->setParameter("pointSize", frameSize);
+        shaders[PathGeometry::kTangents]->setParameter("lineWidth", tangentWidth);
+        shaders[PathGeometry::kHandles]->setParameter("pointSize", handleSize);
+
+        mpManager.getPathGeometry(geometry, stamps, changed);
+        pathCount = static_cast<int>(geometry.size());
+    }
+    else
+    {
+        //filled again from scratch once the buffers are back
+        geometry.clear();
+        stamps.clear();
+    }
+
+    for (int i = 0; i < pathCount; ++i)
+    {
+        if (!changed[i])
+            continue;
+        for (int j = 0; j < PathGeometry::kNumItems; ++j)
+            updateItem(container, itemName(i, j), (PathGeometry::Item) j, geometry[i].positions[j], geometry[i].colors[j]);
+    }
+
+    //paths that went away since the last update
+    for (int i = pathCount; i < numPaths; ++i)
+        for (int j = 0; j < PathGeometry::kNumItems; ++j)
+            removeItem(container, itemName(i, j));
+
+    numPaths = pathCount;
+}
+
+bool MotionPathSubSceneOverride::ensureShaders()
+{
+    if (shaders[0])
+        return true;
+
+    MHWRender::MRenderer *renderer = MHWRender::MRenderer::theRenderer();
+    if (!renderer)
+        return false;
+
+    const MHWRender::MShaderManager *shaderManager = renderer->getShaderManager();
+    if (!shaderManager)
+        return false;
+
+    if (!xrayState)
+    {
+        MHWRender::MDepthStencilStateDesc desc;
+        desc.depthEnable = false;
+        desc.depthWriteEnable = false;
+        xrayState = MHWRender::MStateManager::acquireDepthStencilState(desc);
+    }
+
+    shaders[PathGeometry::kPath] = shaderManager->getStockShader(MHWRender::MShaderManager::k3dCPVThickLineShader, beginXray, endXray);
+    shaders[PathGeometry::kFrames] = shaderManager->getStockShader(MHWRender::MShaderManager::k3dCPVFatPointShader, beginXray, endXray);
+    shaders[PathGeometry::kTangents] = shaderManager->getStockShader(MHWRender::MShaderManager::k3dCPVThickLineShader, beginXray, endXray);
+    shaders[PathGeometry::kHandles] = shaderManager->getStockShader(MHWRender::MShaderManager::k3dCPVFatPointShader, beginXray, endXray);
+
+    for (int i = 0; i < PathGeometry::kNumItems; ++i)
+    {
+        if (!shaders[i])
+        {
+            releaseShaders();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void MotionPathSubSceneOverride::releaseShaders()
+{
+    MHWRender::MRenderer *renderer = MHWRender::MRenderer::theRenderer();
+    const MHWRender::MShaderManager *shaderManager = renderer ? renderer->getShaderManager() : NULL;
+
+    for (int i = 0; i < PathGeometry::kNumItems; ++i)
+    {
+        if (shaders[i] && shaderManager)
+            shaderManager->releaseShader(shaders[i]);
+        shaders[i] = NULL;
+    }
+
+    if (xrayState)
+    {
+        MHWRender::MStateManager::releaseDepthStencilState(xrayState);
+        xrayState = NULL;
+    }
+}
+
+void MotionPathSubSceneOverride::updateItem(MHWRender::MSubSceneContainer &container, const MString &name, const PathGeometry::Item itemType, const std::vector<float> &positions, const std::vector<float> &colors)
+{
+    unsigned int numVertices = static_cast<unsigned int>(positions.size() / 3);
+    MHWRender::MRenderItem *item = container.find(name);
+
+    if (numVertices == 0)
+    {
+        if (item)
+            item->enable(false);
+        return;
+    }
+
+    if (!item)
+    {
+        bool lines = itemType == PathGeometry::kPath || itemType == PathGeometry::kTangents;
+        item = MHWRender::MRenderItem::Create(name, MHWRender::MRenderItem::DecorationItem, lines ? MHWRender::MGeometry::kLines : MHWRender::MGeometry::kPoints);
+        item->setDrawMode(MHWRender::MGeometry::kAll);
+        item->depthPriority(lines ? MHWRender::MRenderItem::sActiveLineDepthPriority : MHWRender::MRenderItem::sActivePointDepthPriority);
+        item->setShader(shaders[itemType]);
+        container.add(item);
+    }
+
+    item->enable(true);
+
+    ItemBuffers &buffers = itemBuffers[name.asChar()];
+    if (buffers.positionBuffer && buffers.positions.size() == positions.size())
+    {
+        //same layout, we look for the first and last vertex that moved or changed color and only send that span again
+        unsigned int first = numVertices;
+        unsigned int last = 0;
+        for (unsigned int i = 0; i < numVertices; ++i)
+        {
+            if (std::memcmp(&positions[i * 3], &buffers.positions[i * 3], 3 * sizeof(float)) != 0 ||
+                std::memcmp(&colors[i * 4], &buffers.colors[i * 4], 4 * sizeof(float)) != 0)
+            {
+                if (first == numVertices)
+                    first = i;
+                last = i;
+            }
+        }
+
+        if (first == numVertices)
+            return;
+
+        unsigned int count = last - first + 1;
+        buffers.positionBuffer->update(&positions[first * 3], first, count, false);
+        buffers.colorBuffer->update(&colors[first * 4], first, count, false);
+    }
+    else
+    {
+        releaseBuffers(buffers);
+
+        MHWRender::MVertexBufferDescriptor positionDesc("", MHWRender::MGeometry::kPosition, MHWRender::MGeometry::kFloat, 3);
+        buffers.positionBuffer = new MHWRender::MVertexBuffer(positionDesc);
+        float *positionData = (float*) buffers.positionBuffer->acquire(numVertices, true);
+        if (positionData)
+        {
+            std::memcpy(positionData, &positions[0], positions.size() * sizeof(float));
+            buffers.positionBuffer->commit(positionData);
+        }
+
+        MHWRender::MVertexBufferDescriptor colorDesc("", MHWRender::MGeometry::kColor, MHWRender::MGeometry::kFloat, 4);
+        buffers.colorBuffer = new MHWRender::MVertexBuffer(colorDesc);
+        float *colorData = (float*) buffers.colorBuffer->acquire(numVertices, true);
+        if (colorData)
+        {
+            std::memcpy(colorData, &colors[0], colors.size() * sizeof(float));
+            buffers.colorBuffer->commit(colorData);
+        }
+
+        //the vertices are already in draw order, the index buffer is only there because the api wants one
+        buffers.indexBuffer = new MHWRender::MIndexBuffer(MHWRender::MGeometry::kUnsignedInt32);
+        unsigned int *indexData = (unsigned int*) buffers.indexBuffer->acquire(numVertices, true);
+        if (indexData)
+        {
+            for (unsigned int i = 0; i < numVertices; ++i)
+                indexData[i] = i;
+            buffers.indexBuffer->commit(indexData);
+        }
+    }
+
+    buffers.positions = positions;
+    buffers.colors = colors;
+
+    MBoundingBox bounds;
+    for (unsigned int i = 0; i < numVertices; ++i)
+        bounds.expand(MPoint(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]));
+
+    MHWRender::MVertexBufferArray vertexBuffers;
+    vertexBuffers.addBuffer("positions", buffers.positionBuffer);
+    vertexBuffers.addBuffer("colors", buffers.colorBuffer);
+    setGeometryForRenderItem(*item, vertexBuffers, *buffers.indexBuffer, &bounds);
+}
+
+void MotionPathSubSceneOverride::removeItem(MHWRender::MSubSceneContainer &container, const MString &name)
+{
+    container.remove(name);
+
+    std::map<std::string, ItemBuffers>::iterator it = itemBuffers.find(name.asChar());
+    if (it != itemBuffers.end())
+    {
+        releaseBuffers(it->second);
+        itemBuffers.erase(it);
+    }
+}
+
+MString MotionPathSubSceneOverride::itemName(const int pathIndex, const int itemType)
+{
+    static const char *names[PathGeometry::kNumItems] = {"path", "frames", "tangents", "handles"};
+
+    MString name("tcMotionPath_");
+    name += pathIndex;
+    name += "_";
+    name += names[itemType];
+    return name;
+}
+
+void MotionPathSubSceneOverride::releaseBuffers(ItemBuffers &buffers)
+{
+    delete buffers.positionBuffer;
+    delete buffers.colorBuffer;
+    delete buffers.indexBuffer;
+
+    buffers.positionBuffer = NULL;
+    buffers.colorBuffer = NULL;
+    buffers.indexBuffer = NULL;
+    buffers.positions.clear();
+    buffers.colors.clear();
+}
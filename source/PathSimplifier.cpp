@@ -0,0 +1,118 @@
+//
+//  PathSimplifier.cpp
+//  MotionPath
+//
+//
+
+#include "PathSimplifier.h"
+
+#include <limits>
+
+struct Span
+{
+    Span(const unsigned int first, const unsigned int last, const double parentError): first(first), last(last), parentError(parentError) {}
+
+    unsigned int first, last;
+    double parentError;
+};
+
+static double distanceToSegment(const MPoint &point, const MPoint &start, const MPoint &end)
+{
+    MVector segment = end - start;
+    double lengthSquared = segment * segment;
+    if (lengthSquared == 0)
+        return point.distanceTo(start);
+
+    double t = ((point - start) * segment) / lengthSquared;
+    if (t < 0) t = 0;
+    if (t > 1) t = 1;
+    return point.distanceTo(start + segment * t);
+}
+
+void PathSimplifier::update(const MPointArray &newPoints)
+{
+    bool same = newPoints.length() == points.size();
+    for (unsigned int i = 0; same && i < points.size(); ++i)
+        same = newPoints[i] == points[i];
+
+    if (same)
+        return;
+
+    points.resize(newPoints.length());
+    for (unsigned int i = 0; i < points.size(); ++i)
+        points[i] = newPoints[i];
+
+    build();
+}
+
+void PathSimplifier::build()
+{
+    unsigned int numPoints = static_cast<unsigned int>(points.size());
+    errors.assign(numPoints, std::numeric_limits<double>::max());
+    if (numPoints < 3)
+        return;
+
+    //iterative so a few thousand frames never get near the stack limit
+    std::vector<Span> spans;
+    spans.push_back(Span(0, numPoints - 1, std::numeric_limits<double>::max()));
+    while (!spans.empty())
+    {
+        Span span = spans.back();
+        spans.pop_back();
+
+        //nothing in between the two ends
+        if (span.last - span.first < 2)
+            continue;
+
+        unsigned int split = span.first + 1;
+        double maxDistance = 0;
+        for (unsigned int i = span.first + 1; i < span.last; ++i)
+        {
+            double distance = distanceToSegment(points[i], points[span.first], points[span.last]);
+            if (distance > maxDistance)
+            {
+                maxDistance = distance;
+                split = i;
+            }
+        }
+
+        double error = maxDistance < span.parentError ? maxDistance : span.parentError;
+        errors[split] = error;
+
+        spans.push_back(Span(span.first, split, error));
+        spans.push_back(Span(split, span.last, error));
+    }
+}
+
+void PathSimplifier::select(const ScreenProjector &projector, const double tolerance, const std::vector<unsigned int> &forced, std::vector<unsigned char> &keepLine, std::vector<unsigned char> &keepDots) const
+{
+    unsigned int numPoints = static_cast<unsigned int>(points.size());
+    keepLine.assign(numPoints, 1);
+    keepDots.assign(numPoints, 1);
+    if (numPoints < 3 || tolerance <= 0)
+        return;
+
+    std::vector<double> pixelSizes(numPoints);
+    for (unsigned int i = 0; i < numPoints; ++i)
+        pixelSizes[i] = projector.pixelSize(points[i]) * tolerance;
+
+    //frames behind the near plane have a size of 0 and so are always kept
+    unsigned int lastDot = 0;
+    for (unsigned int i = 1; i < numPoints - 1; ++i)
+    {
+        keepLine[i] = errors[i] > pixelSizes[i];
+
+        keepDots[i] = points[i].distanceTo(points[lastDot]) > pixelSizes[i];
+        if (keepDots[i])
+            lastDot = i;
+    }
+
+    for (unsigned int i = 0; i < forced.size(); ++i)
+    {
+        if (forced[i] < numPoints)
+        {
+            keepLine[forced[i]] = 1;
+            keepDots[forced[i]] = 1;
+        }
+    }
+}
@@ -0,0 +1,112 @@
+//
+//  PickIndex.cpp
+//  MotionPath
+//
+//
+
+#include "PickIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const int kCellSize = 16;
+//items this far out of the port can still be under a click on its border
+static const int kMargin = 32;
+
+void PickIndex::begin(const int portWidth, const int portHeight)
+{
+    width = portWidth;
+    height = portHeight;
+    columns = width > 0 ? (width + 2 * kMargin + kCellSize - 1) / kCellSize : 0;
+    rows = height > 0 ? (height + 2 * kMargin + kCellSize - 1) / kCellSize : 0;
+    built = false;
+    items.clear();
+    cellStart.clear();
+    cellItems.clear();
+}
+
+void PickIndex::add(const Type type, const int path, const int id, const int tangent, const float x, const float y)
+{
+    if (x < -kMargin || y < -kMargin || x >= width + kMargin || y >= height + kMargin)
+        return;
+
+    Item item;
+    item.type = type;
+    item.path = path;
+    item.id = id;
+    item.tangent = tangent;
+    item.x = x;
+    item.y = y;
+    items.push_back(item);
+}
+
+int PickIndex::cellOf(const double x, const double y) const
+{
+    int column = static_cast<int>(std::floor((x + kMargin) / kCellSize));
+    int row = static_cast<int>(std::floor((y + kMargin) / kCellSize));
+    column = std::max(0, std::min(columns - 1, column));
+    row = std::max(0, std::min(rows - 1, row));
+    return row * columns + column;
+}
+
+void PickIndex::build()
+{
+    unsigned int numCells = columns * rows;
+    cellStart.assign(numCells + 1, 0);
+    cellItems.resize(items.size());
+    built = true;
+    if (numCells == 0)
+        return;
+
+    //counting sort, the items of a cell keep the order they were added in
+    std::vector<unsigned int> itemCells(items.size());
+    for (unsigned int i = 0; i < items.size(); ++i)
+    {
+        itemCells[i] = cellOf(items[i].x, items[i].y);
+        ++cellStart[itemCells[i] + 1];
+    }
+
+    for (unsigned int c = 0; c < numCells; ++c)
+        cellStart[c + 1] += cellStart[c];
+
+    std::vector<unsigned int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (unsigned int i = 0; i < items.size(); ++i)
+        cellItems[fill[itemCells[i]]++] = i;
+}
+
+void PickIndex::query(const Type type, const int path, const double x, const double y, const double radius, std::vector<const Item*> &hits) const
+{
+    hits.clear();
+    if (!built || columns == 0 || rows == 0)
+        return;
+
+    int first = cellOf(x - radius, y - radius);
+    int last = cellOf(x + radius, y + radius);
+    int firstColumn = first % columns, firstRow = first / columns;
+    int lastColumn = last % columns, lastRow = last / columns;
+
+    double maxDistance = radius * radius;
+    std::vector<unsigned int> found;
+    for (int r = firstRow; r <= lastRow; ++r)
+    {
+        for (int c = firstColumn; c <= lastColumn; ++c)
+        {
+            int cell = r * columns + c;
+            for (unsigned int i = cellStart[cell]; i < cellStart[cell + 1]; ++i)
+            {
+                const Item &item = items[cellItems[i]];
+                if (item.type != type || (path != -1 && item.path != path))
+                    continue;
+
+                double dx = x - item.x;
+                double dy = y - item.y;
+                if (dx * dx + dy * dy < maxDistance)
+                    found.push_back(cellItems[i]);
+            }
+        }
+    }
+
+    std::sort(found.begin(), found.end());
+    for (unsigned int i = 0; i < found.size(); ++i)
+        hits.push_back(&items[found[i]]);
+}
@@ -13,6 +13,10 @@ This plugin hooks to maya's postRenderCallback in order to draw the curves in op
 #include "MotionPathEditContext.h"
 #include "MotionPathDrawContext.h"
 #include "MotionPathOverride.h"
+#include "MotionPathGeometryNode.h"
+#include "MotionPathSubSceneOverride.h"
+
+#include <maya/MDrawRegistry.h>
 
 
 MotionPathManager mpManager;
@@ -51,6 +55,20 @@ MStatus initializePlugin(MObject obj)
 		return status;
 	}
 
+	status = plugin.registerNode(MotionPathGeometryNode::typeName, MotionPathGeometryNode::id, MotionPathGeometryNode::creator, MotionPathGeometryNode::initialize, MPxNode::kLocatorNode, &MotionPathGeometryNode::drawDbClassification);
+	if (!status)
+	{
+		MGlobal::displayError("Error registering tcMotionPathGeometry");
+		return status;
+	}
+
+	status = MHWRender::MDrawRegistry::registerSubSceneOverrideCreator(MotionPathGeometryNode::drawDbClassification, MotionPathGeometryNode::drawRegistrantId, MotionPathSubSceneOverride::creator);
+	if (!status)
+	{
+		MGlobal::displayError("Error registering tcMotionPathGeometry subscene override");
+		return status;
+	}
+
 	MHWRender::MRenderer* renderer = MHWRender::MRenderer::theRenderer();
 	if (renderer)
 	{
@@ -205,6 +223,20 @@ MStatus uninitializePlugin(MObject obj)
 		return status;
 	}
 
+	status = MHWRender::MDrawRegistry::deregisterSubSceneOverrideCreator(MotionPathGeometryNode::drawDbClassification, MotionPathGeometryNode::drawRegistrantId);
+	if (!status)
+	{
+		MGlobal::displayError("Error deregistering tcMotionPathGeometry subscene override");
+		return status;
+	}
+
+	status = plugin.deregisterNode(MotionPathGeometryNode::id);
+	if (!status)
+	{
+		MGlobal::displayError("Error deregistering tcMotionPathGeometry");
+		return status;
+	}
+
 	MHWRender::MRenderer* renderer = MHWRender::MRenderer::theRenderer();
 	if (renderer)
 	{
@@ -0,0 +1,100 @@
+//
+//  ProjectionKernel.cpp
+//  MotionPath
+//
+//
+
+#include "ProjectionKernel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PROJECTIONKERNEL_SSE
+#include <emmintrin.h>
+#endif
+
+ProjectionKernel::ProjectionKernel()
+{
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        for (unsigned int j = 0; j < 4; ++j)
+            viewProjection[i][j] = i == j ? 1.0f : 0.0f;
+        viewDepth[i] = 0.0f;
+    }
+
+    halfWidth = halfHeight = 0.0f;
+    minDepth = 0.0f;
+}
+
+void ProjectionKernel::set(const double viewProjection[4][4], const double viewDepth[4], const double halfWidth, const double halfHeight, const double minDepth)
+{
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        for (unsigned int j = 0; j < 4; ++j)
+            this->viewProjection[i][j] = static_cast<float>(viewProjection[i][j]);
+        this->viewDepth[i] = static_cast<float>(viewDepth[i]);
+    }
+
+    this->halfWidth = static_cast<float>(halfWidth);
+    this->halfHeight = static_cast<float>(halfHeight);
+    this->minDepth = static_cast<float>(minDepth);
+}
+
+void ProjectionKernel::project(const float *positions, const unsigned int count, float *screen, unsigned char *visible) const
+{
+    unsigned int first = 0;
+
+#ifdef PROJECTIONKERNEL_SSE
+    const __m128 m00 = _mm_set1_ps(viewProjection[0][0]), m10 = _mm_set1_ps(viewProjection[1][0]), m20 = _mm_set1_ps(viewProjection[2][0]), m30 = _mm_set1_ps(viewProjection[3][0]);
+    const __m128 m01 = _mm_set1_ps(viewProjection[0][1]), m11 = _mm_set1_ps(viewProjection[1][1]), m21 = _mm_set1_ps(viewProjection[2][1]), m31 = _mm_set1_ps(viewProjection[3][1]);
+    const __m128 m03 = _mm_set1_ps(viewProjection[0][3]), m13 = _mm_set1_ps(viewProjection[1][3]), m23 = _mm_set1_ps(viewProjection[2][3]), m33 = _mm_set1_ps(viewProjection[3][3]);
+    const __m128 d0 = _mm_set1_ps(viewDepth[0]), d1 = _mm_set1_ps(viewDepth[1]), d2 = _mm_set1_ps(viewDepth[2]), d3 = _mm_set1_ps(viewDepth[3]);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 nearDepth = _mm_set1_ps(minDepth);
+    const __m128 hw = _mm_set1_ps(halfWidth);
+    const __m128 hh = _mm_set1_ps(halfHeight);
+
+    for (; first + 4 <= count; first += 4)
+    {
+        const float *p = positions + first * 3;
+        __m128 x = _mm_setr_ps(p[0], p[3], p[6], p[9]);
+        __m128 y = _mm_setr_ps(p[1], p[4], p[7], p[10]);
+        __m128 z = _mm_setr_ps(p[2], p[5], p[8], p[11]);
+
+        __m128 depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, d0), _mm_mul_ps(y, d1)), _mm_add_ps(_mm_mul_ps(z, d2), d3));
+        __m128 clipX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m00), _mm_mul_ps(y, m10)), _mm_add_ps(_mm_mul_ps(z, m20), m30));
+        __m128 clipY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m01), _mm_mul_ps(y, m11)), _mm_add_ps(_mm_mul_ps(z, m21), m31));
+        __m128 clipW = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m03), _mm_mul_ps(y, m13)), _mm_add_ps(_mm_mul_ps(z, m23), m33));
+
+        __m128 sx = _mm_mul_ps(_mm_add_ps(_mm_div_ps(clipX, clipW), one), hw);
+        __m128 sy = _mm_mul_ps(_mm_add_ps(_mm_div_ps(clipY, clipW), one), hh);
+
+        _mm_storeu_ps(screen + first * 2, _mm_unpacklo_ps(sx, sy));
+        _mm_storeu_ps(screen + first * 2 + 4, _mm_unpackhi_ps(sx, sy));
+
+        int mask = _mm_movemask_ps(_mm_cmpgt_ps(depth, nearDepth));
+        visible[first] = mask & 1;
+        visible[first + 1] = (mask >> 1) & 1;
+        visible[first + 2] = (mask >> 2) & 1;
+        visible[first + 3] = (mask >> 3) & 1;
+    }
+#endif
+
+    projectScalar(positions, first, count, screen, visible);
+}
+
+void ProjectionKernel::projectScalar(const float *positions, const unsigned int first, const unsigned int last, float *screen, unsigned char *visible) const
+{
+    for (unsigned int i = first; i < last; ++i)
+    {
+        const float *p = positions + i * 3;
+
+        // grouped like the SSE path, (x + y) + (z + w)
+        float depth = (p[0] * viewDepth[0] + p[1] * viewDepth[1]) + (p[2] * viewDepth[2] + viewDepth[3]);
+        float clipX = (p[0] * viewProjection[0][0] + p[1] * viewProjection[1][0]) + (p[2] * viewProjection[2][0] + viewProjection[3][0]);
+        float clipY = (p[0] * viewProjection[0][1] + p[1] * viewProjection[1][1]) + (p[2] * viewProjection[2][1] + viewProjection[3][1]);
+        float clipW = (p[0] * viewProjection[0][3] + p[1] * viewProjection[1][3]) + (p[2] * viewProjection[2][3] + viewProjection[3][3]);
+
+        screen[i * 2] = (clipX / clipW + 1.0f) * halfWidth;
+        screen[i * 2 + 1] = (clipY / clipW + 1.0f) * halfHeight;
+        visible[i] = depth > minDepth ? 1 : 0;
+    }
+}
@@ -0,0 +1,175 @@
+//
+//  ScreenProjector.cpp
+//  MotionPath
+//
+//
+
+#include "ScreenProjector.h"
+
+#include <maya/M3dView.h>
+#include <maya/MFrameContext.h>
+#include <maya/MFnCamera.h>
+#include <maya/MDagPath.h>
+
+// same threshold the per point behind camera test used
+static const double kMinDepth = 0.0001;
+
+static double nearClipOfCamera(const MDagPath &camera)
+{
+    MStatus status;
+    MFnCamera cameraFn(camera, &status);
+    if (!status)
+        return kMinDepth;
+    return cameraFn.nearClippingPlane();
+}
+
+ScreenProjector::ScreenProjector()
+{
+    setMatrices(MMatrix::identity, MMatrix::identity, 0, 0, kMinDepth);
+}
+
+void ScreenProjector::set(const MHWRender::MFrameContext &frameContext)
+{
+    int originX, originY, width, height;
+    frameContext.getViewportDimensions(originX, originY, width, height);
+
+    setMatrices(frameContext.getMatrix(MHWRender::MFrameContext::kViewMtx), frameContext.getMatrix(MHWRender::MFrameContext::kProjectionMtx), width, height, nearClipOfCamera(frameContext.getCurrentCameraPath()));
+}
+
+void ScreenProjector::set(const M3dView &view)
+{
+    MMatrix modelView, projection;
+    view.modelViewMatrix(modelView);
+    view.projectionMatrix(projection);
+
+    MDagPath camera;
+    const_cast<M3dView&>(view).getCamera(camera);
+
+    setMatrices(modelView, projection, view.portWidth(), view.portHeight(), nearClipOfCamera(camera));
+}
+
+void ScreenProjector::setMatrices(const MMatrix &view, const MMatrix &projection, const double width, const double height, const double nearClip)
+{
+    MMatrix viewProj = view * projection;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        for (unsigned int j = 0; j < 4; ++j)
+            viewProjection[i][j] = viewProj[i][j];
+
+        // the camera looks down -z, so the distance in front of it is minus the view space z
+        viewDepth[i] = -view[i][2];
+    }
+
+    halfWidth = width * 0.5;
+    halfHeight = height * 0.5;
+    nearDepth = nearClip > kMinDepth ? nearClip : kMinDepth;
+    pixelScale = projection[0][0] * halfWidth;
+    kernel.set(viewProjection, viewDepth, halfWidth, halfHeight, kMinDepth);
+
+    // the side planes come straight from the columns of the view projection, the near one from the view depth
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        planes[0][i] = viewProj[i][3] + viewProj[i][0];
+        planes[1][i] = viewProj[i][3] - viewProj[i][0];
+        planes[2][i] = viewProj[i][3] + viewProj[i][1];
+        planes[3][i] = viewProj[i][3] - viewProj[i][1];
+        planes[4][i] = viewDepth[i];
+    }
+    planes[4][3] -= nearDepth;
+}
+
+double ScreenProjector::depth(const MPoint &point) const
+{
+    return point.x * viewDepth[0] + point.y * viewDepth[1] + point.z * viewDepth[2] + viewDepth[3];
+}
+
+void ScreenProjector::toScreen(const MPoint &point, MPoint &screen) const
+{
+    double clipX = point.x * viewProjection[0][0] + point.y * viewProjection[1][0] + point.z * viewProjection[2][0] + viewProjection[3][0];
+    double clipY = point.x * viewProjection[0][1] + point.y * viewProjection[1][1] + point.z * viewProjection[2][1] + viewProjection[3][1];
+    double clipW = point.x * viewProjection[0][3] + point.y * viewProjection[1][3] + point.z * viewProjection[2][3] + viewProjection[3][3];
+
+    screen.x = (clipX / clipW + 1.0) * halfWidth;
+    screen.y = (clipY / clipW + 1.0) * halfHeight;
+    screen.z = 0.0;
+}
+
+bool ScreenProjector::projectSegment(const MPoint &start, const MPoint &end, MPoint &screenStart, MPoint &screenEnd) const
+{
+    double startDepth = depth(start);
+    double endDepth = depth(end);
+    if (startDepth < nearDepth && endDepth < nearDepth)
+        return false;
+
+    //the end behind the camera is moved onto the near plane, so the visible part of the segment is kept
+    MPoint clippedStart = start;
+    MPoint clippedEnd = end;
+    if (startDepth < nearDepth)
+        clippedStart = start + (end - start) * ((nearDepth - startDepth) / (endDepth - startDepth));
+    else if (endDepth < nearDepth)
+        clippedEnd = end + (start - end) * ((nearDepth - endDepth) / (startDepth - endDepth));
+
+    toScreen(clippedStart, screenStart);
+    toScreen(clippedEnd, screenEnd);
+    return true;
+}
+
+double ScreenProjector::pixelSize(const MPoint &point) const
+{
+    if (depth(point) < nearDepth || pixelScale == 0)
+        return 0;
+
+    //w is the depth for a perspective camera and 1 for an orthographic one
+    double clipW = point.x * viewProjection[0][3] + point.y * viewProjection[1][3] + point.z * viewProjection[2][3] + viewProjection[3][3];
+    return clipW / pixelScale;
+}
+
+bool ScreenProjector::isBoxVisible(const MPoint &min, const MPoint &max) const
+{
+    for (unsigned int i = 0; i < 5; ++i)
+    {
+        //corner of the box furthest along the plane normal
+        double x = planes[i][0] > 0 ? max.x : min.x;
+        double y = planes[i][1] > 0 ? max.y : min.y;
+        double z = planes[i][2] > 0 ? max.z : min.z;
+        if (x * planes[i][0] + y * planes[i][1] + z * planes[i][2] + planes[i][3] < 0)
+            return false;
+    }
+    return true;
+}
+
+bool ScreenProjector::project(const MPoint &point, double &x, double &y) const
+{
+    if (depth(point) <= kMinDepth)
+        return false;
+
+    MPoint screen;
+    toScreen(point, screen);
+    x = screen.x;
+    y = screen.y;
+    return true;
+}
+
+void ScreenProjector::project(const std::vector<MVector> &points, std::vector<float> &screen, std::vector<unsigned char> &visible) const
+{
+    unsigned int count = static_cast<unsigned int>(points.size());
+    screen.resize(count * 2);
+    visible.resize(count);
+    if (count == 0)
+        return;
+
+    std::vector<float> positions(count * 3);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        positions[i * 3] = static_cast<float>(points[i].x);
+        positions[i * 3 + 1] = static_cast<float>(points[i].y);
+        positions[i * 3 + 2] = static_cast<float>(points[i].z);
+    }
+
+    project(&positions[0], count, &screen[0], &visible[0]);
+}
+
+void ScreenProjector::project(const float *positions, const unsigned int count, float *screen, unsigned char *visible) const
+{
+    kernel.project(positions, count, screen, visible);
+}
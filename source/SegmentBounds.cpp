@@ -0,0 +1,77 @@
+//
+//  SegmentBounds.cpp
+//  MotionPath
+//
+//
+
+#include "SegmentBounds.h"
+
+static void expand(const MPoint &point, MPoint &min, MPoint &max)
+{
+    if (point.x < min.x) min.x = point.x;
+    if (point.y < min.y) min.y = point.y;
+    if (point.z < min.z) min.z = point.z;
+    if (point.x > max.x) max.x = point.x;
+    if (point.y > max.y) max.y = point.y;
+    if (point.z > max.z) max.z = point.z;
+}
+
+void SegmentBounds::clear()
+{
+    numPoints = 0;
+    chunkMin.clear();
+    chunkMax.clear();
+}
+
+void SegmentBounds::build(const MPointArray &points)
+{
+    clear();
+
+    numPoints = points.length();
+    if (numPoints == 0)
+        return;
+
+    unsigned int numChunks = (numPoints + kChunkSize - 1) / kChunkSize;
+    chunkMin.resize(numChunks);
+    chunkMax.resize(numChunks);
+
+    rootMin = points[0];
+    rootMax = points[0];
+    for (unsigned int c = 0; c < numChunks; ++c)
+    {
+        unsigned int first = c * kChunkSize;
+        //one past the chunk, the segment to the next chunk belongs to this one
+        unsigned int last = first + kChunkSize < numPoints ? first + kChunkSize : numPoints - 1;
+
+        MPoint min = points[first];
+        MPoint max = points[first];
+        for (unsigned int i = first + 1; i <= last; ++i)
+            expand(points[i], min, max);
+
+        chunkMin[c] = min;
+        chunkMax[c] = max;
+        expand(min, rootMin, rootMax);
+        expand(max, rootMin, rootMax);
+    }
+}
+
+void SegmentBounds::visibleRanges(const ScreenProjector &projector, std::vector<Range> &ranges) const
+{
+    ranges.clear();
+    if (numPoints == 0 || !projector.isBoxVisible(rootMin, rootMax))
+        return;
+
+    for (unsigned int c = 0; c < chunkMin.size(); ++c)
+    {
+        if (!projector.isBoxVisible(chunkMin[c], chunkMax[c]))
+            continue;
+
+        unsigned int first = c * kChunkSize;
+        unsigned int last = first + kChunkSize < numPoints ? first + kChunkSize : numPoints - 1;
+
+        if (!ranges.empty() && ranges.back().second == first)
+            ranges.back().second = last;
+        else
+            ranges.push_back(Range(first, last));
+    }
+}
@@ -0,0 +1,339 @@
+//
+//  TransformChainEvaluator.cpp
+//  MotionPath
+//
+//
+
+#include "TransformChainEvaluator.h"
+
+#include <maya/MDagPath.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MFnMatrixData.h>
+#include <maya/MPlug.h>
+#include <maya/MPlugArray.h>
+#include <maya/MObject.h>
+#include <maya/MFn.h>
+#include <maya/MTime.h>
+#include <maya/MDGContext.h>
+
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    MMatrix translationMatrix(const MVector &v)
+    {
+        MMatrix m;
+        m[3][0] = v.x;
+        m[3][1] = v.y;
+        m[3][2] = v.z;
+        return m;
+    }
+
+    MMatrix scaleMatrix(const MVector &v)
+    {
+        MMatrix m;
+        m[0][0] = v.x;
+        m[1][1] = v.y;
+        m[2][2] = v.z;
+        return m;
+    }
+
+    double safeInverse(const double value)
+    {
+        return std::fabs(value) > 1e-12 ? 1.0 / value : 1.0;
+    }
+}
+
+TransformChainEvaluator::TransformChainEvaluator()
+{
+    clear();
+}
+
+void TransformChainEvaluator::clear()
+{
+    valid = false;
+    nodes.clear();
+    for (int i = 0; i < 6; ++i)
+        pivots[i].setConstant(0.0);
+}
+
+bool TransformChainEvaluator::isDestination(const MPlug &plug)
+{
+    MPlugArray sources;
+    plug.connectedTo(sources, true, false);
+    return sources.length() > 0;
+}
+
+bool TransformChainEvaluator::snapshotCompound(const MFnDependencyNode &nodeFn, const char *name, AnimCurveEvaluator *channels)
+{
+    MPlug plug = nodeFn.findPlug(name);
+    if (plug.isNull() || isDestination(plug))
+        return false;
+
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        if (!channels[i].snapshot(plug.child(i)))
+            return false;
+    }
+
+    return true;
+}
+
+bool TransformChainEvaluator::snapshotNode(const MFnDependencyNode &nodeFn, const MObject &parent, Node &node)
+{
+    // custom transforms and derived types (constraints, effectors...) compute their matrix in their own way
+    MFn::Type type = nodeFn.object().apiType();
+    if (type != MFn::kTransform && type != MFn::kJoint)
+        return false;
+
+    node.joint = type == MFn::kJoint;
+    node.object = nodeFn.object();
+
+    for (int i = 0; i < kNumChannels; ++i)
+        node.channels[i].setConstant(i >= kScale && i < kShear ? 1.0 : 0.0);
+
+    if (!snapshotCompound(nodeFn, "translate", node.channels + kTranslate) ||
+        !snapshotCompound(nodeFn, "rotate", node.channels + kRotate) ||
+        !snapshotCompound(nodeFn, "scale", node.channels + kScale) ||
+        !snapshotCompound(nodeFn, "rotateAxis", node.channels + kRotateAxis))
+        return false;
+
+    if (node.joint)
+    {
+        if (!snapshotCompound(nodeFn, "jointOrient", node.channels + kJointOrient))
+            return false;
+    }
+    else
+    {
+        if (!snapshotCompound(nodeFn, "shear", node.channels + kShear) ||
+            !snapshotCompound(nodeFn, "rotatePivot", node.channels + kRotatePivot) ||
+            !snapshotCompound(nodeFn, "rotatePivotTranslate", node.channels + kRotatePivotTranslate) ||
+            !snapshotCompound(nodeFn, "scalePivot", node.channels + kScalePivot) ||
+            !snapshotCompound(nodeFn, "scalePivotTranslate", node.channels + kScalePivotTranslate))
+            return false;
+    }
+
+    MPlug rotateOrderPlug = nodeFn.findPlug("rotateOrder");
+    if (isDestination(rotateOrderPlug))
+        return false;
+    node.rotateOrder = static_cast<MEulerRotation::RotationOrder>(rotateOrderPlug.asShort());
+
+    MPlug inheritsPlug = nodeFn.findPlug("inheritsTransform");
+    if (isDestination(inheritsPlug))
+        return false;
+    node.inheritsTransform = inheritsPlug.asBool();
+
+    // offsetParentMatrix only exists from Maya 2020
+    node.offsetParentMatrix = MMatrix::identity;
+    if (nodeFn.hasAttribute("offsetParentMatrix"))
+    {
+        MPlug offsetPlug = nodeFn.findPlug("offsetParentMatrix");
+        if (isDestination(offsetPlug))
+            return false;
+
+        MObject data;
+        offsetPlug.getValue(data);
+        node.offsetParentMatrix = MFnMatrixData(data).matrix();
+    }
+
+    node.segmentScaleCompensate = false;
+    node.inverseScaleFromParent = false;
+    node.inverseScale = MVector(1.0, 1.0, 1.0);
+    if (node.joint)
+    {
+        MPlug compensatePlug = nodeFn.findPlug("segmentScaleCompensate");
+        if (isDestination(compensatePlug))
+            return false;
+        node.segmentScaleCompensate = compensatePlug.asBool();
+
+        MPlug inverseScalePlug = nodeFn.findPlug("inverseScale");
+        MPlugArray sources;
+        inverseScalePlug.connectedTo(sources, true, false);
+        if (sources.length() > 0)
+        {
+            if (parent.isNull() || sources[0].node() != parent || sources[0].attribute() != MFnDependencyNode(parent).attribute("scale"))
+                return false;
+            node.inverseScaleFromParent = true;
+        }
+        else
+        {
+            node.inverseScale = MVector(inverseScalePlug.child(0).asDouble(), inverseScalePlug.child(1).asDouble(), inverseScalePlug.child(2).asDouble());
+        }
+    }
+
+    return true;
+}
+
+bool TransformChainEvaluator::snapshot(const MDagPath &path)
+{
+    clear();
+
+    // parentMatrix[0] of an instanced node is not the matrix of the path we would walk
+    if (path.isInstanced())
+        return false;
+
+    // shapes (i.e. cameras) have no pivots of their own
+    MFnDependencyNode targetFn(path.node());
+    if (targetFn.hasAttribute("rotatePivot"))
+    {
+        if (!snapshotCompound(targetFn, "rotatePivot", pivots) ||
+            !snapshotCompound(targetFn, "rotatePivotTranslate", pivots + 3))
+        {
+            clear();
+            return false;
+        }
+    }
+
+    MDagPath parentPath(path);
+    parentPath.pop();
+    while (parentPath.length() > 0)
+    {
+        MDagPath grandParentPath(parentPath);
+        grandParentPath.pop();
+
+        MObject parentObj = grandParentPath.length() > 0 ? grandParentPath.node() : MObject::kNullObj;
+
+        nodes.push_back(Node());
+        if (!snapshotNode(MFnDependencyNode(parentPath.node()), parentObj, nodes.back()))
+        {
+            clear();
+            return false;
+        }
+
+        parentPath = grandParentPath;
+    }
+
+    valid = true;
+    return true;
+}
+
+bool TransformChainEvaluator::overlayLiveValues(const MObject &node, const MTime &time)
+{
+    static const char *names[3] = {"translate", "rotate", "scale"};
+    static const int offsets[3] = {kTranslate, kRotate, kScale};
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (nodes[i].object != node)
+            continue;
+
+        MFnDependencyNode nodeFn(node);
+        for (int c = 0; c < 3; ++c)
+        {
+            MPlug plug = nodeFn.findPlug(names[c]);
+            for (unsigned int axis = 0; axis < 3; ++axis)
+            {
+                nodes[i].channels[offsets[c] + axis].overlayLiveValue(plug.child(axis), time);
+            }
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+MVector TransformChainEvaluator::evaluateVector(const AnimCurveEvaluator *channels, const double time)
+{
+    return MVector(channels[0].evaluate(time), channels[1].evaluate(time), channels[2].evaluate(time));
+}
+
+MMatrix TransformChainEvaluator::localMatrix(const Node &node, const double time, const MVector &parentScale, MVector &scale)
+{
+    scale = evaluateVector(node.channels + kScale, time);
+
+    MVector rotate = evaluateVector(node.channels + kRotate, time);
+    MVector rotateAxis = evaluateVector(node.channels + kRotateAxis, time);
+    MVector translate = evaluateVector(node.channels + kTranslate, time);
+
+    MMatrix rotation = MEulerRotation(rotate, node.rotateOrder).asMatrix();
+    MMatrix axis = MEulerRotation(rotateAxis).asMatrix();
+
+    MMatrix m;
+    if (node.joint)
+    {
+        // S * RO * R * JO * IS * T
+        MMatrix orient = MEulerRotation(evaluateVector(node.channels + kJointOrient, time)).asMatrix();
+
+        MMatrix inverseScale;
+        if (node.segmentScaleCompensate)
+        {
+            const MVector &is = node.inverseScaleFromParent ? parentScale : node.inverseScale;
+            inverseScale = scaleMatrix(MVector(safeInverse(is.x), safeInverse(is.y), safeInverse(is.z)));
+        }
+
+        m = scaleMatrix(scale) * axis * rotation * orient * inverseScale * translationMatrix(translate);
+    }
+    else
+    {
+        // SP^-1 * S * SH * SP * ST * RP^-1 * RA * R * RP * RT * T
+        MVector shear = evaluateVector(node.channels + kShear, time);
+        MMatrix shearMatrix;
+        shearMatrix[1][0] = shear.x;
+        shearMatrix[2][0] = shear.y;
+        shearMatrix[2][1] = shear.z;
+
+        MVector scalePivot = evaluateVector(node.channels + kScalePivot, time);
+        MVector rotatePivot = evaluateVector(node.channels + kRotatePivot, time);
+
+        m = translationMatrix(-scalePivot) * scaleMatrix(scale) * shearMatrix * translationMatrix(scalePivot + evaluateVector(node.channels + kScalePivotTranslate, time)) *
+            translationMatrix(-rotatePivot) * axis * rotation * translationMatrix(rotatePivot + evaluateVector(node.channels + kRotatePivotTranslate, time) + translate);
+    }
+
+    return m * node.offsetParentMatrix;
+}
+
+MMatrix TransformChainEvaluator::parentMatrix(const double time) const
+{
+    MMatrix m;
+    MVector parentScale(1.0, 1.0, 1.0);
+
+    // walking down from the root so that joints can pick up the scale of the joint above
+    for (int i = static_cast<int>(nodes.size()) - 1; i >= 0; --i)
+    {
+        MVector scale;
+        MMatrix local = localMatrix(nodes[i], time, parentScale, scale);
+        m = nodes[i].inheritsTransform ? local * m : local;
+        parentScale = scale;
+    }
+
+    return m;
+}
+
+MVector TransformChainEvaluator::rotatePivot(const double time) const
+{
+    return evaluateVector(pivots, time);
+}
+
+MVector TransformChainEvaluator::rotatePivotTranslate(const double time) const
+{
+    return evaluateVector(pivots + 3, time);
+}
+
+bool TransformChainEvaluator::validate(const MPlug &parentMatrixPlug, const std::vector<double> &times, const double tolerance) const
+{
+    if (!valid)
+        return false;
+
+    for (size_t i = 0; i < times.size(); ++i)
+    {
+        MDGContext context(MTime(times[i], MTime::kSeconds));
+        MObject data;
+        parentMatrixPlug.getValue(data, context);
+        MMatrix dgMatrix = MFnMatrixData(data).matrix();
+        MMatrix nativeMatrix = parentMatrix(times[i]);
+
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int col = 0; col < 4; ++col)
+            {
+                double expected = dgMatrix[row][col];
+                if (std::fabs(nativeMatrix[row][col] - expected) > tolerance * std::max(1.0, std::fabs(expected)))
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
@@ -11,203 +11,101 @@
 
 #define PI 3.1415
 
-void VP2DrawUtils::drawLineStipple(const MVector &origin, const MVector &target, float lineWidth, const MColor &color, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
+void VP2DrawUtils::drawLineStipple(const MVector &origin, const MVector &target, float lineWidth, const MColor &color, const ScreenProjector &projector, MHWRender::MUIDrawManager* drawManager)
 {
-	MVector zVec(cameraMatrix[2][0], cameraMatrix[2][1], cameraMatrix[2][2]);
-	MVector cPos(cameraMatrix[3][0], cameraMatrix[3][1], cameraMatrix[3][2]);
-	if ((cPos - origin) * zVec <= 0.0001)
+	MPoint start, end;
+	if (!projector.projectSegment(origin, target, start, end))
 		return;
 
 	drawManager->setColor(color);
 	drawManager->setLineWidth(lineWidth);
 	drawManager->setPaintStyle(MHWRender::MUIDrawManager::kStippled);
 	drawManager->setLineStyle(8, 0xAAAA);
-	double x1, y1, x2, y2;
-	frameContext->worldToViewport(origin, x1, y1);
-	frameContext->worldToViewport(target, x2, y2);
-	drawManager->line2d(MPoint(x1, y1), MPoint(x2, y2));
+	drawManager->line2d(start, end);
 }
 
 
-void VP2DrawUtils::drawLine(const MVector &origin, const MVector &target, float lineWidth, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager,  const MHWRender::MFrameContext* frameContext)
+void VP2DrawUtils::drawLine(const MVector &origin, const MVector &target, float lineWidth, const ScreenProjector &projector, MHWRender::MUIDrawManager* drawManager)
 {
-	MVector zVec(cameraMatrix[2][0], cameraMatrix[2][1], cameraMatrix[2][2]);
-	MVector cPos(cameraMatrix[3][0], cameraMatrix[3][1], cameraMatrix[3][2]);
-	if ((cPos - origin) * zVec <= 0.0001)
+	MPoint start, end;
+	if (!projector.projectSegment(origin, target, start, end))
 		return;
 
 	drawManager->setLineWidth(lineWidth);
-	double x1, y1, x2, y2;
-	frameContext->worldToViewport(origin, x1, y1);
-	frameContext->worldToViewport(target, x2, y2);
-	drawManager->line2d(MPoint(x1, y1), MPoint(x2, y2));
+	drawManager->line2d(start, end);
 }
 
 
-void VP2DrawUtils::drawLineWithColor(const MVector &origin, const MVector &target, float lineWidth, const MColor &color, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
+void VP2DrawUtils::drawLineWithColor(const MVector &origin, const MVector &target, float lineWidth, const MColor &color, const ScreenProjector &projector, MHWRender::MUIDrawManager* drawManager)
 {
 	drawManager->setColor(color);
-	VP2DrawUtils::drawLine(origin, target, lineWidth, cameraMatrix, drawManager, frameContext);
+	VP2DrawUtils::drawLine(origin, target, lineWidth, projector, drawManager);
 }
 
 
-void VP2DrawUtils::drawPoint(const MVector &point, float size, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
+void VP2DrawUtils::drawPoint(const MVector &point, float size, const ScreenProjector &projector, MHWRender::MUIDrawManager* drawManager)
 {
-	MVector zVec(cameraMatrix[2][0], cameraMatrix[2][1], cameraMatrix[2][2]);
-	MVector cPos(cameraMatrix[3][0], cameraMatrix[3][1], cameraMatrix[3][2]);
-	if ((cPos - point) * zVec  <= 0.0001)
+	double x, y; 
+	if (!projector.project(point, x, y))
 		return;
 
-	double x, y; 
-	frameContext->worldToViewport(point, x, y);
 	drawManager->circle2d(MPoint(x, y), size / 2, true);
 }
 
 
-void VP2DrawUtils::drawPointWithColor(const MVector &point, float size, const MColor &color, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
+void VP2DrawUtils::drawPointWithColor(const MVector &point, float size, const MColor &color, const ScreenProjector &projector, MHWRender::MUIDrawManager* drawManager)
 {
 	drawManager->setColor(color);
-	VP2DrawUtils::drawPoint(point, size, cameraMatrix, drawManager, frameContext);
+	VP2DrawUtils::drawPoint(point, size, projector, drawManager);
 }
 
-void VP2DrawUtils::drawKeyFrames(std::vector<Keyframe *> keys, const float size, const double colorMultiplier, const int portWidth, const int portHeight, const bool showRotationKeyframes, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
+void VP2DrawUtils::drawLineMesh(const MPointArray &points, const MColorArray *colors, const bool strip, float lineWidth, const MColor &color, MHWRender::MUIDrawManager* drawManager)
 {
-	for (unsigned int ki = 0; ki < keys.size(); ++ki)
-	{
-		Keyframe* key = keys[ki];
-		if (!key)
-			continue;
-
-		std::vector<Keyframe::Axis> tAxis, rAxis;
-		key->getKeyTranslateAxis(tAxis);
-		//std::cout << key->time << std::endl;
-		if (tAxis.size() < 1)
-		{
-			//std::cout << "axis 0 " << key->time << std::endl;
-			continue;
-		}
-		if (showRotationKeyframes)
-			key->getKeyRotateAxis(rAxis);
-
-		double blackBackgroundFactor = 1.2;
-		MColor color(0.0, 0.0, 0.0);
-		double centerX, centerY;
-		frameContext->worldToViewport(key->worldPosition, centerX, centerY);
-
-		drawManager->setColor(color);
-		drawManager->circle2d(MPoint(centerX, centerY), size * blackBackgroundFactor / 2, true);
-
-		if (key->selectedFromTool)
-		{
-			MColor color(1.0, 1.0, 1.0);
-			drawManager->setColor(color);
-			drawManager->circle2d(MPoint(centerX, centerY), size / 2, true);
-		}
-		else
-		{
-			double stepSize = size / 2 / tAxis.size();
-			for (int i = 0; i < tAxis.size(); ++i)
-			{
-				Keyframe::getColorForAxis(tAxis[i], color);
-				color *= colorMultiplier;
-
-				drawManager->setColor(color);
-				drawManager->circle2d(MPoint(centerX, centerY), stepSize * (tAxis.size() - i), true);
-			}
-
-			/*
-			int nSections = 3;
-			int step = nSections / tAxis.size();
-			int currentStep = 0;
-			//std::cout << "triangle 1" << std::endl;
-			Keyframe::getColorForAxis(tAxis[currentStep], color);
-			color *= colorMultiplier;
-
-			double angleAdd = (2.0 * double(PI) / double(nSections));
-			double angle = -PI / 2;
-
-			double x1 = 0, y1 = -1, x2, y2;
-			for (int i = 0; i < nSections; ++i)
-			{
-				//std::cout << i << std::endl;
-				if (i / step > currentStep)
-				{
-					currentStep = i / step;
-					if (currentStep == tAxis.size()) currentStep = 0;
-					Keyframe::getColorForAxis(tAxis[currentStep], color);
-					color *= colorMultiplier;
-				}
-
-				angle -= angleAdd;
-				x2 = size * 0.5 * sin(angle);
-				y2 = size * 0.5 * cos(angle);
-
-				MPointArray points;
-				points.append(MPoint(centerX, centerY));
-				points.append(MPoint(centerX + x1, centerY + y1));
-				points.append(MPoint(centerX + x2, centerY + y2));
-
-				drawManager->setColor(color);
-				drawManager->mesh2d(MHWRender::MUIDrawManager::kTriangles, points);
-				//drawManager->arc2d(MPoint(centerX, centerY), MVector(x1, y1), MVector(x2, y2), size / 2, true);
-				x1 = x2;
-				y1 = y2;
-			}
-			*/
-			
-		}
-
-		if (rAxis.size() > 0)
-		{
-			double lineWidth = size / 5;
-			if (lineWidth < 1) lineWidth = 1;
-
-			double unit = size * blackBackgroundFactor / 2;
-			float x1s[3] = { -unit * 0.8, unit * 1.5,  unit * -1.5 };
-			float y1s[3] = { unit * 1.2,  unit * 0.1,  unit * 0.1 };
-
-			float x2s[3] = { unit * 0.8,  unit * 0.7,  unit * -0.7 };
-			float y2s[3] = { unit * 1.2,  unit * -1.2, unit * -1.2 };
-
-			MColor color;
-			MVector p1(0, 0, 0), p2(0, 0, 0);
-			for (unsigned int i = 0; i < rAxis.size(); ++i)
-			{
-				Keyframe::getColorForAxis(rAxis[i], color);
-				color *= colorMultiplier;
-
-				p1.x = centerX + x1s[i];
-				p1.y = centerY + y1s[i];
-
-				p2.x = centerX + x2s[i];
-				p2.y = centerY + y2s[i];
-
-				drawManager->setColor(color);
-				drawManager->setLineWidth(lineWidth);
-				drawManager->line2d(p1, p2);
-			}
-		}
-	}
+	if (points.length() < 2)
+		return;
+
+	//drawn in world space as a single drawable, the gpu takes care of projecting and clipping
+	drawManager->setColor(color);
+	drawManager->setLineWidth(lineWidth);
+	drawManager->mesh(strip ? MHWRender::MUIDrawManager::kLineStrip : MHWRender::MUIDrawManager::kLines, points, NULL, colors);
 }
 
-void VP2DrawUtils::drawKeyFramePoints(KeyframeMap &keyframesCache, const float size, const double colorMultiplier, const int portWidth, const int portHeight, const bool showRotationKeyframes, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
+void VP2DrawUtils::drawPointMesh(const MPointArray &points, float size, const MColor &color, MHWRender::MUIDrawManager* drawManager)
+{
+	if (points.length() == 0)
+		return;
+
+	drawManager->setColor(color);
+	drawManager->setPointSize(size);
+	drawManager->mesh(MHWRender::MUIDrawManager::kPoints, points);
+}
+
+void VP2DrawUtils::drawKeyFramePoints(KeyframeMap &keyframesCache, KeyGlyphCache &glyphCache, const float size, const double colorMultiplier, const bool showRotationKeyframes, const ScreenProjector &projector, MHWRender::MUIDrawManager* drawManager)
 {
 	std::vector<Keyframe *> keys;
+	std::vector<MVector> positions;
 	keys.reserve(keyframesCache.size());
+	positions.reserve(keyframesCache.size());
 
 	for (KeyframeMapIterator keyIt = keyframesCache.begin(); keyIt != keyframesCache.end(); keyIt++)
 	{
-		Keyframe* key = &keyIt->second;
-		if (!key)
-			continue;
-		MVector zVec(cameraMatrix[2][0], cameraMatrix[2][1], cameraMatrix[2][2]);
-		MVector cPos(cameraMatrix[3][0], cameraMatrix[3][1], cameraMatrix[3][2]);
-		if ((cPos - key->worldPosition) * zVec  <= 0.0001)
-			continue;
-		keys.push_back(key);
+		keys.push_back(&keyIt->second);
+		positions.push_back(keyIt->second.worldPosition);
 	}
 
-	drawKeyFrames(keys, size, colorMultiplier, portWidth, portHeight, showRotationKeyframes, cameraMatrix, drawManager, frameContext);
+	//the glyphs only change with the keys or their selection, the camera just moves them around
+	glyphCache.update(keys, size, colorMultiplier, showRotationKeyframes);
+
+	//all the keys of the path are projected in one go, the ones behind the camera are dropped
+	std::vector<float> screen;
+	std::vector<unsigned char> visible;
+	projector.project(positions, screen, visible);
+
+	std::vector<MPoint> centers(keys.size());
+	for (unsigned int i = 0; i < keys.size(); ++i)
+		centers[i] = MPoint(screen[i * 2], screen[i * 2 + 1]);
+
+	glyphCache.draw(centers, visible, drawManager);
 }
 
 void VP2DrawUtils::convertWorldSpaceToCameraSpace(CameraCache* cachePtr, std::map<double, MPoint> &positions, std::map<double, MPoint> &screenSpacePositions, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
@@ -215,22 +113,13 @@ void VP2DrawUtils::convertWorldSpaceToCameraSpace(CameraCache* cachePtr, std::ma
 	
 }
 
-void VP2DrawUtils::drawFrameLabel(double frame, const MVector &framePos, M3dView &view, const double sizeOffset, const MColor &color, const MMatrix &cameraMatrix, MHWRender::MUIDrawManager* drawManager, const MHWRender::MFrameContext* frameContext)
+void VP2DrawUtils::drawFrameLabel(double frame, const double viewX, const double viewY, const double sizeOffset, const MColor &color, MHWRender::MUIDrawManager* drawManager)
 {
-	MVector zVec(cameraMatrix[2][0], cameraMatrix[2][1], cameraMatrix[2][2]);
-	MVector cPos(cameraMatrix[3][0], cameraMatrix[3][1], cameraMatrix[3][2]);
-	if ((cPos - framePos) * zVec  <= 0.0001)
-		return;
-
 	drawManager->setFontSize(MHWRender::MUIDrawManager::kDefaultFontSize);
 	drawManager->setColor(color);
-	
-	double viewX, viewY;
-	frameContext->worldToViewport(framePos, viewX, viewY);
 
 	MString frameStr;
 	frameStr = frame;
 
 	drawManager->text(MPoint(viewX, viewY + (GlobalSettings::frameSize * sizeOffset)), frameStr, MHWRender::MUIDrawManager::kCenter);
 }
-
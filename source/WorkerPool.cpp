@@ -0,0 +1,163 @@
+//
+//  WorkerPool.cpp
+//  MotionPath
+//
+//
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool()
+{
+    generation = 0;
+    pending = 0;
+    quit = false;
+    start(1);
+}
+
+WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+void WorkerPool::setNumThreads(const int numThreads)
+{
+    int count = numThreads;
+    if (count <= 0)
+        count = static_cast<int>(std::thread::hardware_concurrency());
+    if (count <= 0)
+        count = 1;
+
+    if (count == getNumThreads())
+        return;
+
+    stop();
+    start(count);
+}
+
+void WorkerPool::start(const int numThreads)
+{
+    quit = false;
+
+    // queue 0 belongs to the calling thread
+    for (int i = 0; i < numThreads; ++i)
+        queues.push_back(new Queue());
+
+    for (int i = 1; i < numThreads; ++i)
+        threads.push_back(std::thread(&WorkerPool::workerLoop, this, i));
+}
+
+void WorkerPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wakeCondition.notify_all();
+
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+    threads.clear();
+
+    for (size_t i = 0; i < queues.size(); ++i)
+        delete queues[i];
+    queues.clear();
+}
+
+bool WorkerPool::runOne(const int index)
+{
+    Task *task = NULL;
+
+    {
+        Queue &own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+        }
+    }
+
+    for (size_t i = 1; task == NULL && i < queues.size(); ++i)
+    {
+        Queue &other = *queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty())
+        {
+            task = other.tasks.front();
+            other.tasks.pop_front();
+        }
+    }
+
+    if (task == NULL)
+        return false;
+
+    (*task)();
+
+    bool done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = --pending == 0;
+    }
+    if (done)
+        doneCondition.notify_all();
+
+    return true;
+}
+
+void WorkerPool::workerLoop(const int index)
+{
+    unsigned int seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!quit && (generation == seenGeneration || pending == 0))
+                wakeCondition.wait(lock);
+
+            if (quit)
+                return;
+            seenGeneration = generation;
+        }
+
+        while (runOne(index));
+    }
+}
+
+void WorkerPool::run(std::vector<Task> &tasks)
+{
+    if (tasks.empty())
+        return;
+
+    if (queues.size() == 1 || tasks.size() == 1)
+    {
+        for (size_t i = 0; i < tasks.size(); ++i)
+            tasks[i]();
+        return;
+    }
+
+    //a worker still draining the previous run can pick up a task as soon as it is queued, so the count goes first.
+    //The generation only moves once everything is queued so that a woken worker doesn't find the queues empty and go back to sleep
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = static_cast<int>(tasks.size());
+    }
+
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        Queue &queue = *queues[i % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(&tasks[i]);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++generation;
+    }
+    wakeCondition.notify_all();
+
+    while (runOne(0));
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (pending > 0)
+        doneCondition.wait(lock);
+}
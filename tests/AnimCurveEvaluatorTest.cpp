@@ -0,0 +1,312 @@
+//
+//  AnimCurveEvaluatorTest.cpp
+//  MotionPath
+//
+//
+
+// Checks AnimCurveEvaluator against reference values without a Maya session, run with "make test".
+// The curves are built so that every intermediate value is exactly representable, the expected
+// values were worked out with rational arithmetic and have to match bit for bit.
+// Only the weighted segments whose time is not linear go through an iterative solve and get a tolerance.
+
+#include "AnimCurveEvaluator.h"
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+static int failures = 0;
+
+static void checkExact(const char *name, const double value, const double expected)
+{
+    if (value == expected)
+        return;
+
+    std::printf("FAILED %s: got %.17g, expected %.17g\n", name, value, expected);
+    ++failures;
+}
+
+static void checkNear(const char *name, const double value, const double expected, const double tolerance)
+{
+    if (std::fabs(value - expected) <= tolerance)
+        return;
+
+    std::printf("FAILED %s: got %.17g, expected %.17g\n", name, value, expected);
+    ++failures;
+}
+
+static AnimCurveEvaluator::Key makeKey(const double time, const double value, const double inX, const double inY, const double outX, const double outY)
+{
+    AnimCurveEvaluator::Key key;
+    key.time = time;
+    key.value = value;
+    key.inX = inX;
+    key.inY = inY;
+    key.outX = outX;
+    key.outY = outY;
+    key.stepOut = false;
+    key.stepNextOut = false;
+    key.fixedTangents = true;
+    return key;
+}
+
+// evaluateRange must give exactly what evaluate gives, whatever segment walking it does
+static void checkRange(const char *name, const AnimCurveEvaluator &curve, const double start, const double step, const int count)
+{
+    std::vector<double> values(count);
+    curve.evaluateRange(start, step, count, &values[0]);
+    for (int i = 0; i < count; ++i)
+        checkExact(name, values[i], curve.evaluate(start + i * step));
+}
+
+static void testHermite()
+{
+    std::vector<AnimCurveEvaluator::Key> keys;
+    keys.push_back(makeKey(0.0, 0.0, 1.0, 0.0, 1.0, 2.0));
+    keys.push_back(makeKey(1.0, 1.0, 2.0, 1.0, 1.0, -1.0));
+    keys.push_back(makeKey(2.0, 4.0, 1.0, 4.0, 1.0, 4.0));
+
+    AnimCurveEvaluator curve;
+    if (!curve.setKeys(keys, false, AnimCurveEvaluator::kConstant, AnimCurveEvaluator::kConstant))
+    {
+        checkExact("hermite setKeys", 0.0, 1.0);
+        return;
+    }
+
+    checkExact("hermite key 0", curve.evaluate(0.0), 0.0);
+    checkExact("hermite key 1", curve.evaluate(1.0), 1.0);
+    checkExact("hermite key 2", curve.evaluate(2.0), 4.0);
+
+    checkExact("hermite 0.25", curve.evaluate(0.25), 53.0 / 128.0);
+    checkExact("hermite 0.5", curve.evaluate(0.5), 11.0 / 16.0);
+    checkExact("hermite 0.75", curve.evaluate(0.75), 111.0 / 128.0);
+    checkExact("hermite 1.25", curve.evaluate(1.25), 73.0 / 64.0);
+    checkExact("hermite 1.5", curve.evaluate(1.5), 15.0 / 8.0);
+    checkExact("hermite 1.75", curve.evaluate(1.75), 187.0 / 64.0);
+
+    checkRange("hermite range", curve, -0.5, 0.125, 25);
+    // frames at 24fps, odd runs per segment so that the batch leaves a tail
+    checkRange("hermite frames", curve, -0.3, 1.0 / 24.0, 61);
+    checkRange("hermite frames offset", curve, 0.01, 1.0 / 24.0, 47);
+}
+
+static void testWeighted()
+{
+    std::vector<AnimCurveEvaluator::Key> keys;
+    keys.push_back(makeKey(0.0, 0.0, 3.0, 3.0, 3.0, 3.0));
+    keys.push_back(makeKey(3.0, 6.0, 3.0, 0.0, 1.5, 0.0));
+    keys.push_back(makeKey(6.0, 2.0, 6.0, -3.0, 6.0, -3.0));
+
+    AnimCurveEvaluator curve;
+    if (!curve.setKeys(keys, true, AnimCurveEvaluator::kConstant, AnimCurveEvaluator::kConstant))
+    {
+        checkExact("weighted setKeys", 0.0, 1.0);
+        return;
+    }
+
+    checkExact("weighted key 0", curve.evaluate(0.0), 0.0);
+    checkExact("weighted key 1", curve.evaluate(3.0), 6.0);
+    checkExact("weighted key 2", curve.evaluate(6.0), 2.0);
+
+    // the first segment has its time control points at thirds, so time is linear in the bezier parameter
+    checkExact("weighted 0.75", curve.evaluate(0.75), 87.0 / 64.0);
+    checkExact("weighted 1.5", curve.evaluate(1.5), 27.0 / 8.0);
+
+    // the second one is not, these go through the solve
+    checkNear("weighted 3.5", curve.evaluate(3.5), 5.304763905610786, 1e-9);
+    checkNear("weighted 4", curve.evaluate(4.0), 4.251735295975691, 1e-9);
+    checkNear("weighted 5", curve.evaluate(5.0), 2.765300364394718, 1e-9);
+    checkNear("weighted 5.5", curve.evaluate(5.5), 2.3114441394303937, 1e-9);
+
+    checkRange("weighted range", curve, -1.0, 0.25, 33);
+}
+
+static void testStep()
+{
+    std::vector<AnimCurveEvaluator::Key> keys;
+    keys.push_back(makeKey(0.0, 1.0, 1.0, 0.0, 1.0, 0.0));
+    keys.push_back(makeKey(1.0, 3.0, 1.0, 0.0, 1.0, 0.0));
+    keys.push_back(makeKey(2.0, -2.0, 1.0, 0.0, 1.0, 0.0));
+    keys[0].stepOut = true;
+    keys[1].stepNextOut = true;
+
+    AnimCurveEvaluator curve;
+    if (!curve.setKeys(keys, false, AnimCurveEvaluator::kConstant, AnimCurveEvaluator::kConstant))
+    {
+        checkExact("step setKeys", 0.0, 1.0);
+        return;
+    }
+
+    // step holds the key value up to the next key
+    checkExact("step 0", curve.evaluate(0.0), 1.0);
+    checkExact("step 0.5", curve.evaluate(0.5), 1.0);
+    checkExact("step 0.999", curve.evaluate(0.999), 1.0);
+    checkExact("step 1", curve.evaluate(1.0), 3.0);
+
+    // step next jumps to the next value right after the key
+    checkExact("step next 1.001", curve.evaluate(1.001), -2.0);
+    checkExact("step next 1.5", curve.evaluate(1.5), -2.0);
+    checkExact("step next 2", curve.evaluate(2.0), -2.0);
+
+    checkRange("step range", curve, -0.5, 0.125, 25);
+}
+
+// keys at 0, 1 and 2 with values 1, 2 and 0, the in range values used below are
+// f(0.5) = 13/8 and f(1.5) = 5/4
+static bool makeInfinityCurve(AnimCurveEvaluator &curve, const AnimCurveEvaluator::Infinity pre, const AnimCurveEvaluator::Infinity post)
+{
+    std::vector<AnimCurveEvaluator::Key> keys;
+    keys.push_back(makeKey(0.0, 1.0, 1.0, 0.5, 1.0, 1.0));
+    keys.push_back(makeKey(1.0, 2.0, 1.0, 0.0, 1.0, 0.0));
+    keys.push_back(makeKey(2.0, 0.0, 1.0, -2.0, 1.0, -2.0));
+
+    if (curve.setKeys(keys, false, pre, post))
+        return true;
+
+    checkExact("infinity setKeys", 0.0, 1.0);
+    return false;
+}
+
+static void testInfinity()
+{
+    AnimCurveEvaluator curve;
+
+    if (makeInfinityCurve(curve, AnimCurveEvaluator::kConstant, AnimCurveEvaluator::kConstant))
+    {
+        checkExact("in range 0.5", curve.evaluate(0.5), 13.0 / 8.0);
+        checkExact("in range 1.5", curve.evaluate(1.5), 5.0 / 4.0);
+        checkExact("constant pre", curve.evaluate(-1.5), 1.0);
+        checkExact("constant post", curve.evaluate(3.25), 0.0);
+        checkRange("constant range", curve, -3.0, 0.25, 33);
+    }
+
+    // linear follows the in tangent of the first key and the out tangent of the last one
+    if (makeInfinityCurve(curve, AnimCurveEvaluator::kLinear, AnimCurveEvaluator::kLinear))
+    {
+        checkExact("linear pre -2", curve.evaluate(-2.0), 0.0);
+        checkExact("linear pre -0.5", curve.evaluate(-0.5), 0.75);
+        checkExact("linear post 3", curve.evaluate(3.0), -2.0);
+        checkExact("linear post 2.25", curve.evaluate(2.25), -0.5);
+        checkRange("linear range", curve, -3.0, 0.25, 33);
+    }
+
+    if (makeInfinityCurve(curve, AnimCurveEvaluator::kCycle, AnimCurveEvaluator::kCycle))
+    {
+        checkExact("cycle pre -0.5", curve.evaluate(-0.5), 5.0 / 4.0);
+        checkExact("cycle pre -3.5", curve.evaluate(-3.5), 13.0 / 8.0);
+        checkExact("cycle pre -4", curve.evaluate(-4.0), 1.0);
+        checkExact("cycle post 2.5", curve.evaluate(2.5), 13.0 / 8.0);
+        checkExact("cycle post 5.5", curve.evaluate(5.5), 5.0 / 4.0);
+        checkRange("cycle range", curve, -5.0, 0.25, 57);
+    }
+
+    // each cycle is offset by the difference between the last and the first value, -1 here
+    if (makeInfinityCurve(curve, AnimCurveEvaluator::kCycleRelative, AnimCurveEvaluator::kCycleRelative))
+    {
+        checkExact("cycle relative pre -0.5", curve.evaluate(-0.5), 9.0 / 4.0);
+        checkExact("cycle relative pre -3.5", curve.evaluate(-3.5), 29.0 / 8.0);
+        checkExact("cycle relative post 2.5", curve.evaluate(2.5), 5.0 / 8.0);
+        checkExact("cycle relative post 5.5", curve.evaluate(5.5), -3.0 / 4.0);
+        checkExact("cycle relative post 4", curve.evaluate(4.0), -1.0);
+        checkRange("cycle relative range", curve, -5.0, 0.25, 57);
+    }
+
+    // every other cycle runs backwards
+    if (makeInfinityCurve(curve, AnimCurveEvaluator::kOscillate, AnimCurveEvaluator::kOscillate))
+    {
+        checkExact("oscillate pre -0.5", curve.evaluate(-0.5), 13.0 / 8.0);
+        checkExact("oscillate pre -2.5", curve.evaluate(-2.5), 5.0 / 4.0);
+        checkExact("oscillate pre -3.5", curve.evaluate(-3.5), 13.0 / 8.0);
+        checkExact("oscillate post 2.5", curve.evaluate(2.5), 5.0 / 4.0);
+        checkExact("oscillate post 4.5", curve.evaluate(4.5), 13.0 / 8.0);
+        checkExact("oscillate post 6.5", curve.evaluate(6.5), 5.0 / 4.0);
+        checkRange("oscillate range", curve, -5.0, 0.25, 57);
+    }
+
+    // mixed modes on either side
+    if (makeInfinityCurve(curve, AnimCurveEvaluator::kOscillate, AnimCurveEvaluator::kLinear))
+    {
+        checkExact("mixed pre", curve.evaluate(-0.5), 13.0 / 8.0);
+        checkExact("mixed post", curve.evaluate(3.0), -2.0);
+    }
+
+    // a single key is constant unless one of the infinities is linear
+    std::vector<AnimCurveEvaluator::Key> single(1, makeKey(1.0, 2.0, 1.0, 0.5, 1.0, -1.0));
+    if (curve.setKeys(single, false, AnimCurveEvaluator::kCycle, AnimCurveEvaluator::kOscillate))
+    {
+        checkExact("single key pre", curve.evaluate(-3.0), 2.0);
+        checkExact("single key post", curve.evaluate(7.0), 2.0);
+    }
+    if (curve.setKeys(single, false, AnimCurveEvaluator::kLinear, AnimCurveEvaluator::kLinear))
+    {
+        checkExact("single key linear pre", curve.evaluate(-1.0), 1.0);
+        checkExact("single key linear post", curve.evaluate(3.0), 0.0);
+    }
+}
+
+// moving a key on the snapshot has to give the same curve as snapshotting the moved key
+static void testOffsetKey()
+{
+    std::vector<AnimCurveEvaluator::Key> keys;
+    keys.push_back(makeKey(0.0, 0.0, 1.0, 0.0, 1.0, 2.0));
+    keys.push_back(makeKey(1.0, 1.0, 2.0, 1.0, 1.0, -1.0));
+    keys.push_back(makeKey(2.0, 4.0, 1.0, 4.0, 1.0, 4.0));
+    keys.push_back(makeKey(3.0, 2.0, 1.0, 0.0, 1.0, 0.0));
+
+    AnimCurveEvaluator offset;
+    offset.setKeys(keys, false, AnimCurveEvaluator::kCycle, AnimCurveEvaluator::kLinear);
+    checkExact("offset key found", offset.offsetKey(1.0, 0.5) ? 1.0 : 0.0, 1.0);
+    checkExact("offset missing key", offset.offsetKey(1.5, 0.5) ? 1.0 : 0.0, 0.0);
+
+    keys[1].value += 0.5;
+    AnimCurveEvaluator rebuilt;
+    rebuilt.setKeys(keys, false, AnimCurveEvaluator::kCycle, AnimCurveEvaluator::kLinear);
+
+    for (int i = 0; i <= 56; ++i)
+    {
+        double time = -2.0 + i * 0.125;
+        checkExact("offset key", offset.evaluate(time), rebuilt.evaluate(time));
+    }
+}
+
+// tangents that follow the keys would be recomputed by Maya, the snapshot refuses to move those keys
+static void testOffsetKeyTangents()
+{
+    std::vector<AnimCurveEvaluator::Key> keys;
+    keys.push_back(makeKey(0.0, 0.0, 1.0, 0.0, 1.0, 2.0));
+    keys.push_back(makeKey(1.0, 1.0, 2.0, 1.0, 1.0, -1.0));
+    keys.push_back(makeKey(2.0, 4.0, 1.0, 4.0, 1.0, 4.0));
+    keys.push_back(makeKey(3.0, 2.0, 1.0, 0.0, 1.0, 0.0));
+    keys[0].fixedTangents = false;
+
+    AnimCurveEvaluator curve;
+    curve.setKeys(keys, false, AnimCurveEvaluator::kConstant, AnimCurveEvaluator::kConstant);
+
+    // the key itself and the one next to it can't move, the one further away can
+    checkExact("offset auto key", curve.offsetKey(0.0, 0.5) ? 1.0 : 0.0, 0.0);
+    checkExact("offset next to auto key", curve.offsetKey(1.0, 0.5) ? 1.0 : 0.0, 0.0);
+    checkExact("offset away from auto key", curve.offsetKey(2.0, 0.5) ? 1.0 : 0.0, 1.0);
+
+    // a refused offset leaves the curve alone
+    checkExact("refused offset", curve.evaluate(1.0), 1.0);
+    checkExact("refused offset", curve.evaluate(0.5), 11.0 / 16.0);
+}
+
+int main()
+{
+    testHermite();
+    testWeighted();
+    testStep();
+    testInfinity();
+    testOffsetKey();
+    testOffsetKeyTangents();
+
+    if (failures > 0)
+    {
+        std::printf("%d AnimCurveEvaluator checks failed\n", failures);
+        return 1;
+    }
+
+    std::printf("AnimCurveEvaluator checks passed\n");
+    return 0;
+}
@@ -0,0 +1,234 @@
+//
+//  ProjectionBenchmark.cpp
+//  MotionPath
+//
+//
+
+// Batch projection against the per point path, run with "make bench" (the checks also run with "make test").
+// The per point path is the double precision math of ScreenProjector::project(const MPoint&), the batch one is
+// ProjectionKernel. Fails if the SSE blocks and the scalar tail do not give the same bits for the same point.
+
+#include "ProjectionKernel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static const unsigned int kNumPoints = 1000003;
+static const double kMinDepth = 0.0001;
+
+static unsigned int seed = 4321;
+
+static double randomValue(const double low, const double high)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return low + (high - low) * (seed >> 8) / 16777216.0;
+}
+
+struct Camera
+{
+    double viewProjection[4][4];
+    double viewDepth[4];
+    double halfWidth, halfHeight;
+};
+
+// camera at (12, 8, 20) turned towards the origin with a 45 degrees vertical field of view, row vectors like MMatrix.
+// It is not aligned with any axis so that every term of the projection counts
+static void makeCamera(Camera &camera)
+{
+    double yaw = 0.54, pitch = -0.33;
+    double position[3] = {12, 8, 20};
+    double world[3][3] = {
+        {std::cos(yaw), 0, -std::sin(yaw)},
+        {std::sin(yaw) * std::sin(pitch), std::cos(pitch), std::cos(yaw) * std::sin(pitch)},
+        {std::sin(yaw) * std::cos(pitch), -std::sin(pitch), std::cos(yaw) * std::cos(pitch)}};
+
+    // the inverse of the camera matrix, transposed rotation and the position brought back through it
+    double view[4][4];
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        for (unsigned int j = 0; j < 3; ++j)
+            view[i][j] = world[j][i];
+        view[i][3] = 0;
+        view[3][i] = -(position[0] * world[i][0] + position[1] * world[i][1] + position[2] * world[i][2]);
+    }
+    view[3][3] = 1;
+
+    double width = 1920, height = 1080;
+    double nearClip = 0.1, farClip = 1000.0;
+    double f = 1.0 / std::tan(45.0 * 3.14159265358979323846 / 360.0);
+    double projection[4][4] = {
+        {f * height / width, 0, 0, 0},
+        {0, f, 0, 0},
+        {0, 0, (farClip + nearClip) / (nearClip - farClip), -1},
+        {0, 0, 2.0 * farClip * nearClip / (nearClip - farClip), 0}};
+
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        for (unsigned int j = 0; j < 4; ++j)
+        {
+            camera.viewProjection[i][j] = 0;
+            for (unsigned int k = 0; k < 4; ++k)
+                camera.viewProjection[i][j] += view[i][k] * projection[k][j];
+        }
+        camera.viewDepth[i] = -view[i][2];
+    }
+
+    camera.halfWidth = width * 0.5;
+    camera.halfHeight = height * 0.5;
+}
+
+static bool projectPoint(const Camera &camera, const double *p, double &x, double &y)
+{
+    double depth = p[0] * camera.viewDepth[0] + p[1] * camera.viewDepth[1] + p[2] * camera.viewDepth[2] + camera.viewDepth[3];
+    if (depth <= kMinDepth)
+        return false;
+
+    const double (*m)[4] = camera.viewProjection;
+    double clipX = p[0] * m[0][0] + p[1] * m[1][0] + p[2] * m[2][0] + m[3][0];
+    double clipY = p[0] * m[0][1] + p[1] * m[1][1] + p[2] * m[2][1] + m[3][1];
+    double clipW = p[0] * m[0][3] + p[1] * m[1][3] + p[2] * m[2][3] + m[3][3];
+
+    x = (clipX / clipW + 1.0) * camera.halfWidth;
+    y = (clipY / clipW + 1.0) * camera.halfHeight;
+    return true;
+}
+
+template <typename Function>
+static double bestOf(const int repeats, Function function)
+{
+    double best = 0.0;
+    for (int r = 0; r < repeats; ++r)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        function();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (r == 0 || ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+struct BatchRun
+{
+    const ProjectionKernel *kernel;
+    const float *positions;
+    float *screen;
+    unsigned char *visible;
+    void operator()() const {kernel->project(positions, kNumPoints, screen, visible);}
+};
+
+struct ScalarRun
+{
+    const ProjectionKernel *kernel;
+    const float *positions;
+    float *screen;
+    unsigned char *visible;
+    void operator()() const {kernel->projectScalar(positions, 0, kNumPoints, screen, visible);}
+};
+
+struct PointRun
+{
+    const Camera *camera;
+    const double *positions;
+    double *screen;
+    unsigned char *visible;
+    void operator()() const
+    {
+        for (unsigned int i = 0; i < kNumPoints; ++i)
+            visible[i] = projectPoint(*camera, positions + i * 3, screen[i * 2], screen[i * 2 + 1]);
+    }
+};
+
+int main(int argc, char **argv)
+{
+    int repeats = argc > 1 ? std::atoi(argv[1]) : 5;
+    if (repeats < 1)
+        repeats = 1;
+
+    Camera camera;
+    makeCamera(camera);
+
+    ProjectionKernel kernel;
+    kernel.set(camera.viewProjection, camera.viewDepth, camera.halfWidth, camera.halfHeight, kMinDepth);
+
+    // a path wandering in front of the camera, some of it behind
+    std::vector<double> points(kNumPoints * 3);
+    std::vector<float> positions(kNumPoints * 3);
+    for (unsigned int i = 0; i < kNumPoints * 3; ++i)
+    {
+        points[i] = randomValue(-30.0, 30.0);
+        positions[i] = static_cast<float>(points[i]);
+    }
+
+    std::vector<float> batchScreen(kNumPoints * 2), scalarScreen(kNumPoints * 2);
+    std::vector<unsigned char> batchVisible(kNumPoints), scalarVisible(kNumPoints);
+    std::vector<double> pointScreen(kNumPoints * 2);
+    std::vector<unsigned char> pointVisible(kNumPoints);
+
+    BatchRun batch = {&kernel, &positions[0], &batchScreen[0], &batchVisible[0]};
+    ScalarRun scalar = {&kernel, &positions[0], &scalarScreen[0], &scalarVisible[0]};
+    PointRun perPoint = {&camera, &points[0], &pointScreen[0], &pointVisible[0]};
+
+    double batchMs = bestOf(repeats, batch);
+    double scalarMs = bestOf(repeats, scalar);
+    double pointMs = bestOf(repeats, perPoint);
+
+    // the same point has to come out the same whether it went through an SSE block or the scalar tail
+    bool identical = std::memcmp(&batchScreen[0], &scalarScreen[0], batchScreen.size() * sizeof(float)) == 0 &&
+        std::memcmp(&batchVisible[0], &scalarVisible[0], batchVisible.size()) == 0;
+
+    // shifting the start moves every point between the blocks and the tail
+    for (unsigned int offset = 1; offset < 4; ++offset)
+    {
+        unsigned int count = 1000 + offset;
+        std::vector<float> screen(count * 2);
+        std::vector<unsigned char> visible(count);
+        kernel.project(&positions[offset * 3], count, &screen[0], &visible[0]);
+        if (std::memcmp(&screen[0], &scalarScreen[offset * 2], screen.size() * sizeof(float)) != 0 ||
+            std::memcmp(&visible[0], &scalarVisible[offset], visible.size()) != 0)
+            identical = false;
+    }
+
+    // float against double, only where both agree the point is in front of the camera
+    double maxError = 0.0;
+    unsigned int visibleMismatches = 0;
+    for (unsigned int i = 0; i < kNumPoints; ++i)
+    {
+        if (batchVisible[i] != pointVisible[i])
+        {
+            ++visibleMismatches;
+            continue;
+        }
+        if (!pointVisible[i])
+            continue;
+
+        double x = pointScreen[i * 2], y = pointScreen[i * 2 + 1];
+        // far outside the viewport the float error grows with the coordinate, it is not drawn anyway
+        if (x < 0 || x > 2 * camera.halfWidth || y < 0 || y > 2 * camera.halfHeight)
+            continue;
+
+        double error = std::max(std::fabs(batchScreen[i * 2] - x), std::fabs(batchScreen[i * 2 + 1] - y));
+        if (error > maxError)
+            maxError = error;
+    }
+
+    std::printf("%u points\n", kNumPoints);
+    std::printf("batch      %7.2f ms %6.2f ns/point\n", batchMs, batchMs * 1.0e6 / kNumPoints);
+    std::printf("scalar     %7.2f ms %6.2f ns/point\n", scalarMs, scalarMs * 1.0e6 / kNumPoints);
+    std::printf("per point  %7.2f ms %6.2f ns/point, batch is %.2fx faster\n", pointMs, pointMs * 1.0e6 / kNumPoints, pointMs / batchMs);
+    std::printf("largest difference to the per point path %g pixels, %u visibility mismatches\n", maxError, visibleMismatches);
+
+    if (!identical)
+    {
+        std::printf("FAILED the SSE and scalar paths differ\n");
+        return 1;
+    }
+
+    std::printf("SSE and scalar paths identical\n");
+    return 0;
+}
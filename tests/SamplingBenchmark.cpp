@@ -0,0 +1,204 @@
+//
+//  SamplingBenchmark.cpp
+//  MotionPath
+//
+//
+
+// Scaling of the path sampling across the worker pool, run with "make bench".
+// The synthetic scene mirrors what MotionPathManager::cachePathSamples hands to the pool: 500 paths
+// over 5000 frames, each with animated translate curves under a two level animated hierarchy, split in
+// chunks of 64 frames. Every run is compared bit for bit against the single threaded one.
+
+#include "AnimCurveEvaluator.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static const int kNumPaths = 500;
+static const int kNumFrames = 5000;
+static const int kNumKeys = 60;
+static const int kSampleChunkSize = 64;
+static const int kParentLevels = 2;
+static const double kSecondsPerFrame = 1.0 / 24.0;
+
+struct SyntheticPath
+{
+    AnimCurveEvaluator translate[3];
+    // translate and rotate of each ancestor
+    AnimCurveEvaluator parents[kParentLevels][6];
+};
+
+static unsigned int seed = 12345;
+
+static double randomValue(const double low, const double high)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return low + (high - low) * (seed >> 8) / 16777216.0;
+}
+
+static void makeCurve(AnimCurveEvaluator &curve, const double amplitude)
+{
+    std::vector<AnimCurveEvaluator::Key> keys(kNumKeys);
+    double step = kNumFrames * kSecondsPerFrame / (kNumKeys - 1);
+    for (int i = 0; i < kNumKeys; ++i)
+    {
+        AnimCurveEvaluator::Key &key = keys[i];
+        key.time = i * step;
+        key.value = randomValue(-amplitude, amplitude);
+        key.inX = key.outX = step;
+        key.inY = key.outY = randomValue(-amplitude, amplitude) * 0.5;
+        key.stepOut = false;
+        key.stepNextOut = false;
+        key.fixedTangents = true;
+    }
+
+    curve.setKeys(keys, false, AnimCurveEvaluator::kCycle, AnimCurveEvaluator::kCycle);
+}
+
+// row major, row vectors like MMatrix
+static void localMatrix(const double *t, const double *r, double *m)
+{
+    double cx = std::cos(r[0]), sx = std::sin(r[0]);
+    double cy = std::cos(r[1]), sy = std::sin(r[1]);
+    double cz = std::cos(r[2]), sz = std::sin(r[2]);
+
+    m[0] = cy * cz;                 m[1] = cy * sz;                 m[2] = -sy;
+    m[3] = sx * sy * cz - cx * sz;  m[4] = sx * sy * sz + cx * cz;  m[5] = sx * cy;
+    m[6] = cx * sy * cz + sx * sz;  m[7] = cx * sy * sz - sx * cz;  m[8] = cx * cy;
+    m[9] = t[0];                    m[10] = t[1];                   m[11] = t[2];
+}
+
+static void multiply(const double *a, const double *b, double *result)
+{
+    for (int row = 0; row < 4; ++row)
+    {
+        for (int column = 0; column < 3; ++column)
+        {
+            double value = a[row * 3] * b[column] + a[row * 3 + 1] * b[3 + column] + a[row * 3 + 2] * b[6 + column];
+            if (row == 3)
+                value += b[9 + column];
+            result[row * 3 + column] = value;
+        }
+    }
+}
+
+static void computeSamples(const SyntheticPath &path, const int first, const int count, double *positions)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        double seconds = (first + i) * kSecondsPerFrame;
+
+        double parent[12] = {1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0};
+        for (int level = 0; level < kParentLevels; ++level)
+        {
+            double t[3], r[3], local[12], composed[12];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                t[axis] = path.parents[level][axis].evaluate(seconds);
+                r[axis] = path.parents[level][3 + axis].evaluate(seconds);
+            }
+            localMatrix(t, r, local);
+            multiply(parent, local, composed);
+            std::memcpy(parent, composed, sizeof(parent));
+        }
+
+        double p[3];
+        for (int axis = 0; axis < 3; ++axis)
+            p[axis] = path.translate[axis].evaluate(seconds);
+
+        double *world = positions + 3 * (first + i);
+        for (int axis = 0; axis < 3; ++axis)
+            world[axis] = p[0] * parent[axis] + p[1] * parent[3 + axis] + p[2] * parent[6 + axis] + parent[9 + axis];
+    }
+}
+
+static double run(WorkerPool &pool, const std::vector<SyntheticPath> &paths, std::vector<std::vector<double> > &positions)
+{
+    // cleared so that a chunk that did not run can not pass for the previous run
+    for (int i = 0; i < kNumPaths; ++i)
+        std::fill(positions[i].begin(), positions[i].end(), 0.0);
+
+    std::vector<WorkerPool::Task> tasks;
+    for (int i = 0; i < kNumPaths; ++i)
+    {
+        const SyntheticPath *path = &paths[i];
+        double *pathPositions = &positions[i][0];
+        for (int first = 0; first < kNumFrames; first += kSampleChunkSize)
+        {
+            int chunk = std::min(kSampleChunkSize, kNumFrames - first);
+            tasks.push_back([path, first, chunk, pathPositions]() {computeSamples(*path, first, chunk, pathPositions);});
+        }
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    pool.run(tasks);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    int repeats = argc > 1 ? std::atoi(argv[1]) : 3;
+    if (repeats < 1)
+        repeats = 1;
+
+    std::vector<SyntheticPath> paths(kNumPaths);
+    for (int i = 0; i < kNumPaths; ++i)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+            makeCurve(paths[i].translate[axis], 10.0);
+        for (int level = 0; level < kParentLevels; ++level)
+        {
+            for (int channel = 0; channel < 6; ++channel)
+                makeCurve(paths[i].parents[level][channel], channel < 3 ? 20.0 : 3.0);
+        }
+    }
+
+    std::vector<std::vector<double> > reference(kNumPaths, std::vector<double>(3 * kNumFrames));
+    std::vector<std::vector<double> > positions(kNumPaths, std::vector<double>(3 * kNumFrames));
+
+    std::printf("%d paths x %d frames, %u hardware threads\n", kNumPaths, kNumFrames, std::thread::hardware_concurrency());
+    std::printf("threads      ms   speedup\n");
+
+    WorkerPool pool;
+    bool identical = true;
+    double singleThreaded = 0.0;
+    const int threadCounts[] = {1, 2, 4, 8, 16, 32};
+    for (unsigned int i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); ++i)
+    {
+        pool.setNumThreads(threadCounts[i]);
+
+        double best = 0.0;
+        for (int r = 0; r < repeats; ++r)
+        {
+            double ms = run(pool, paths, i == 0 ? reference : positions);
+            if (r == 0 || ms < best)
+                best = ms;
+
+            for (int p = 0; i > 0 && p < kNumPaths; ++p)
+            {
+                if (std::memcmp(&positions[p][0], &reference[p][0], positions[p].size() * sizeof(double)) != 0)
+                    identical = false;
+            }
+        }
+
+        if (i == 0)
+            singleThreaded = best;
+        std::printf("%7d %7.1f %8.2fx\n", threadCounts[i], best, singleThreaded / best);
+    }
+
+    if (!identical)
+    {
+        std::printf("FAILED the threaded samples differ from the single threaded ones\n");
+        return 1;
+    }
+
+    std::printf("samples identical across thread counts\n");
+    return 0;
+}